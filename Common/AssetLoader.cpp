@@ -0,0 +1,240 @@
+#include "AssetLoader.h"
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+AssetLoader::AssetLoader(unsigned threads)
+{
+    if (threads == 0) {
+        unsigned cores = thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(&AssetLoader::workerLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+    stop();
+}
+
+void AssetLoader::stop()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& worker : workers)
+        worker.join();
+    workers.clear();
+
+    for (Job* job : queued)
+        delete job;
+    queued.clear();
+    Job* job = completed.exchange(nullptr, memory_order_acquire);
+    while (job) {
+        Job* next = job->next;
+        delete job;
+        job = next;
+    }
+    inFlight = 0;
+}
+
+void AssetLoader::submit(function<void()> work, function<void()> finish)
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (stopping)
+            return;
+        inFlight++;
+        queued.push_back(new Job{ std::move(work), std::move(finish) });
+    }
+    wake.notify_one();
+}
+
+void AssetLoader::workerLoop()
+{
+    for (;;) {
+        Job* job;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            wake.wait(lock, [this] { return stopping || !queued.empty(); });
+            if (stopping)
+                return;
+            job = queued.front();
+            queued.pop_front();
+        }
+
+        job->work();
+
+        job->next = completed.load(memory_order_relaxed);
+        while (!completed.compare_exchange_weak(job->next, job, memory_order_release, memory_order_relaxed))
+            ;
+    }
+}
+
+size_t AssetLoader::poll()
+{
+    Job* stack = completed.exchange(nullptr, memory_order_acquire);
+
+    // A pilha sai na ordem inversa da conclusão
+    Job* ordered = nullptr;
+    while (stack) {
+        Job* next = stack->next;
+        stack->next = ordered;
+        ordered = stack;
+        stack = next;
+    }
+
+    size_t count = 0;
+    while (ordered) {
+        Job* next = ordered->next;
+        ordered->finish();
+        delete ordered;
+        ordered = next;
+        inFlight--;
+        count++;
+    }
+    return count;
+}
+
+void loadMeshAsync(AssetLoader& loader, const char* objPath, const glm::vec3& color, const VertexFormat& format,
+                   function<void(GpuMesh&)> ready, MaterialLibraryHook onMaterialLibrary)
+{
+    auto prepared = make_shared<PreparedMesh>();
+    auto ok = make_shared<bool>(false);
+    string path = objPath;
+
+    loader.submit(
+        [prepared, ok, path, format, onMaterialLibrary] {
+            *ok = prepareMesh(path.c_str(), format, *prepared, onMaterialLibrary);
+        },
+        [prepared, ok, color, ready] {
+            GpuMesh gpu;
+            if (*ok) {
+                gpu = uploadPreparedMesh(*prepared);
+                gpu.color = color;
+            }
+            ready(gpu);
+        });
+}
+
+void loadMeshAsync(AssetLoader& loader, UploadScheduler& scheduler, const char* objPath, const glm::vec3& color,
+                   const VertexFormat& format, function<void(GpuMesh&)> ready, MaterialLibraryHook onMaterialLibrary)
+{
+    auto prepared = make_shared<PreparedMesh>();
+    auto ok = make_shared<bool>(false);
+    string path = objPath;
+
+    loader.submit(
+        [prepared, ok, path, format, onMaterialLibrary] {
+            *ok = prepareMesh(path.c_str(), format, *prepared, onMaterialLibrary);
+        },
+        [prepared, ok, color, ready, &scheduler] {
+            if (*ok) {
+                uploadPreparedMeshScheduled(scheduler, prepared, color, ready);
+            }
+            else {
+                GpuMesh empty;
+                ready(empty);
+            }
+        });
+}
+
+void loadMeshAsync(AssetLoader& loader, UploadThread& uploader, const char* objPath, const glm::vec3& color,
+                   const VertexFormat& format, function<void(GpuMesh&)> ready, MaterialLibraryHook onMaterialLibrary)
+{
+    string path = objPath;
+    loader.submit(
+        [&uploader, path, color, format, ready, onMaterialLibrary] {
+            auto prepared = make_shared<PreparedMesh>();
+            if (prepareMesh(path.c_str(), format, *prepared, onMaterialLibrary))
+                uploadPreparedMeshThreaded(uploader, prepared, color, ready);
+            else
+                uploader.submit([] {}, [ready] {
+                    GpuMesh empty;
+                    ready(empty);
+                });
+        },
+        [] {});
+}
+
+void loadMaterialsAsync(AssetLoader& loader, const string& mtlPath,
+                        function<void(const string& mtlPath, vector<Material>&)> materialsReady,
+                        TextureCache* textures, function<void(shared_ptr<PreparedTexture>)> textureReady)
+{
+    auto library = make_shared<vector<Material>>();
+    loader.submit(
+        [mtlPath, library, textures, textureReady] {
+            if (!loadMTL(mtlPath.c_str(), *library) || !textures)
+                return;
+
+            // As decodificações entram na fila antes de este trabalho terminar
+            vector<string> paths;
+            for (const Material& material : *library)
+                if (!material.diffuseMap.empty() && find(paths.begin(), paths.end(), material.diffuseMap) == paths.end())
+                    paths.push_back(material.diffuseMap);
+            for (const string& path : paths)
+                textures->request(path, [textureReady](shared_ptr<PreparedTexture> texture) {
+                    if (textureReady)
+                        textureReady(texture);
+                });
+        },
+        [mtlPath, library, materialsReady] { materialsReady(mtlPath, *library); });
+}
+
+GpuMesh createPlaceholderMesh(const glm::vec3& color)
+{
+    IndexedMesh mesh;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = -1; side <= 1; side += 2) {
+            glm::vec3 normal(0.0f);
+            normal[axis] = (float)side;
+            glm::vec3 u(0.0f), v(0.0f);
+            u[(axis + 1) % 3] = 0.5f;
+            v[(axis + 2) % 3] = 0.5f * side; // mantém a face no sentido anti-horário
+
+            uint32_t base = (uint32_t)mesh.vertices.size();
+            const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+            for (const auto& c : corners) {
+                MeshVertex vertex;
+                vertex.position = normal * 0.5f + u * c[0] + v * c[1];
+                vertex.color = color;
+                vertex.normal = normal;
+                vertex.uv = glm::vec2(c[0] * 0.5f + 0.5f, c[1] * 0.5f + 0.5f);
+                mesh.vertices.push_back(vertex);
+            }
+            const uint32_t quad[6] = { 0, 1, 2, 0, 2, 3 };
+            for (uint32_t i : quad)
+                mesh.indices.push_back(base + i);
+        }
+    }
+    mesh.ranges.push_back(MeshRange{ 0, (uint32_t)mesh.indices.size(), -1, -1, glm::vec3(0.0f), glm::vec3(0.0f) });
+    computeMeshBounds(mesh);
+
+    GpuMesh gpu = uploadMesh(mesh);
+    gpu.color = color;
+    return gpu;
+}
+
+void LoadTimer::frameShown(bool assetsReady)
+{
+    if (firstFrameShown && (finalFrameShown || !assetsReady))
+        return;
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if (!firstFrameShown) {
+        firstFrameShown = true;
+        cout << "Primeiro quadro em " << ms << " ms" << endl;
+    }
+    if (assetsReady && !finalFrameShown) {
+        finalFrameShown = true;
+        cout << "Quadro com todos os assets em " << ms << " ms" << endl;
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Material.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+#include "TextureCache.h"
+#include "UploadScheduler.h"
+#include "UploadThread.h"
+
+// Carregamento assíncrono de assets. As threads de trabalho fazem a parte de
+// CPU (leitura, decodificação, montagem da malha) e devolvem cada trabalho
+// concluído por uma fila sem trava; a thread dona do contexto GL chama poll()
+// uma vez por quadro e só faz os envios para a GPU.
+struct AssetLoader
+{
+    // 0 = um a menos que o número de núcleos (pelo menos 1)
+    explicit AssetLoader(unsigned threads = 0);
+    // Chama stop()
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // `work` roda em uma thread de trabalho; `finish` roda depois, na thread
+    // que chama poll(). Pode ser chamado de qualquer thread, inclusive de
+    // dentro de um `work`, para encadear etapas sem passar pela thread do GL.
+    void submit(std::function<void()> work, std::function<void()> finish);
+
+    // Executa os `finish` dos trabalhos concluídos, na ordem de conclusão, e
+    // retorna quantos rodaram
+    size_t poll();
+
+    // Trabalhos enviados cujo `finish` ainda não rodou
+    size_t pending() const { return inFlight; }
+
+    // Espera os trabalhos em andamento e encerra as threads; os que ainda
+    // estavam na fila e os `finish` pendentes são descartados, e novos
+    // pedidos são ignorados. Chamar antes de destruir o que os trabalhos
+    // usam (a UploadThread, o contexto GL).
+    void stop();
+
+private:
+    struct Job
+    {
+        std::function<void()> work;
+        std::function<void()> finish;
+        Job* next = nullptr;
+    };
+
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    std::deque<Job*> queued;
+    bool stopping = false;
+
+    // Pilha de Treiber: as threads de trabalho empilham com compare_exchange e
+    // poll() retira a pilha inteira de uma vez com exchange, então não há ABA
+    std::atomic<Job*> completed{nullptr};
+    std::atomic<size_t> inFlight{0};
+};
+
+// Prepara a malha (cache ou OBJ) em uma thread de trabalho e, dentro de
+// poll(), envia para a GPU e entrega a `ready`. Em caso de erro `ready` recebe
+// uma malha vazia (VAO == 0). `onMaterialLibrary` roda na thread de trabalho
+// assim que o mtllib é lido (ver prepareMesh), por exemplo para chamar
+// loadMaterialsAsync enquanto a malha ainda está sendo montada.
+void loadMeshAsync(AssetLoader& loader, const char* objPath, const glm::vec3& color, const VertexFormat& format,
+                   std::function<void(GpuMesh&)> ready, MaterialLibraryHook onMaterialLibrary = nullptr);
+
+// Igual, mas o envio passa pelo `scheduler`, fatiado ao longo dos quadros;
+// `ready` roda quando o último pedaço chega à GPU
+void loadMeshAsync(AssetLoader& loader, UploadScheduler& scheduler, const char* objPath, const glm::vec3& color,
+                   const VertexFormat& format, std::function<void(GpuMesh&)> ready,
+                   MaterialLibraryHook onMaterialLibrary = nullptr);
+
+// Igual, mas a thread de trabalho entrega a malha direto à thread de envio
+// com contexto compartilhado; nada roda no laço de renderização até a fence
+// da cópia ser sinalizada
+void loadMeshAsync(AssetLoader& loader, UploadThread& uploader, const char* objPath, const glm::vec3& color,
+                   const VertexFormat& format, std::function<void(GpuMesh&)> ready,
+                   MaterialLibraryHook onMaterialLibrary = nullptr);
+
+// Lê o .mtl em uma thread de trabalho e, assim que ele termina, pede o
+// map_Kd dos materiais a `textures`, que prepara cada arquivo uma vez em
+// outras threads. Em poll(), `materialsReady` recebe a lista (vazia se o .mtl
+// não abrir) e `textureReady` cada textura, na ordem em que ficarem prontas
+// (nullptr para as que falharem); sem `textures` nenhuma textura é lida. Pode
+// ser chamada de uma thread de trabalho.
+void loadMaterialsAsync(AssetLoader& loader, const std::string& mtlPath,
+                        std::function<void(const std::string& mtlPath, std::vector<Material>&)> materialsReady,
+                        TextureCache* textures = nullptr,
+                        std::function<void(std::shared_ptr<PreparedTexture>)> textureReady = nullptr);
+
+// Cubo de lado 1 centrado na origem, desenhado enquanto a malha real não chega
+GpuMesh createPlaceholderMesh(const glm::vec3& color);
+
+// Latências do carregamento, medidas a partir da construção: até o primeiro
+// quadro apresentado e até o primeiro quadro com todos os assets reais
+struct LoadTimer
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool firstFrameShown = false;
+    bool finalFrameShown = false;
+
+    // Chamar logo após glfwSwapBuffers; imprime cada latência uma vez
+    void frameShown(bool assetsReady);
+};
@@ -0,0 +1,111 @@
+#include "AssetWatcher.h"
+#include "MeshCache.h"
+
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+AssetWatcher::AssetWatcher()
+{
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+        cout << "inotify indisponível; verificando datas de modificação a cada " << pollInterval.count() << " ms"
+             << endl;
+#endif
+}
+
+AssetWatcher::~AssetWatcher()
+{
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+#endif
+}
+
+bool AssetWatcher::watch(const string& path, Callback changed)
+{
+    filesystem::path file(path);
+    Entry entry;
+    entry.path = path;
+    entry.directory = file.has_parent_path() ? file.parent_path().string() : string(".");
+    entry.name = file.filename().string();
+    entry.changed = std::move(changed);
+
+    SourceStamp stamp;
+    if (readSourceStamp(path.c_str(), stamp))
+        entry.lastWrite = stamp.time;
+
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        // Repetir o diretório devolve o mesmo watch
+        entry.watchId = inotify_add_watch(inotifyFd, entry.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (entry.watchId < 0) {
+            cout << "Não foi possível observar " << entry.directory << endl;
+            return false;
+        }
+    }
+#endif
+
+    entries.push_back(std::move(entry));
+    return true;
+}
+
+size_t AssetWatcher::poll()
+{
+    Clock::time_point now = Clock::now();
+    vector<bool> dirty(entries.size(), false);
+
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+            for (char* p = buffer; p < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                if (event->len > 0) {
+                    for (size_t i = 0; i < entries.size(); i++) {
+                        if (entries[i].watchId == event->wd && entries[i].name == event->name)
+                            dirty[i] = true;
+                    }
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+    else
+#endif
+    {
+        if (now - lastScan < pollInterval)
+            return 0;
+        lastScan = now;
+        for (size_t i = 0; i < entries.size(); i++) {
+            SourceStamp stamp;
+            if (readSourceStamp(entries[i].path.c_str(), stamp) && stamp.time != entries[i].lastWrite) {
+                entries[i].lastWrite = stamp.time;
+                dirty[i] = true;
+            }
+        }
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!dirty[i])
+            continue;
+        // Cópias: o callback pode registrar novos arquivos e realocar `entries`
+        string path = entries[i].path;
+        Callback changed = entries[i].changed;
+        cout << "Arquivo alterado: " << path << endl;
+        changed(path, now);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Observa arquivos de assets e avisa quando são regravados, para recarregar só
+// o arquivo que mudou. No Linux usa inotify nos diretórios (editores costumam
+// salvar em um temporário e renomear, o que invalidaria um watch no próprio
+// arquivo); nos outros sistemas compara a data de modificação a cada
+// `pollInterval`.
+struct AssetWatcher
+{
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void(const std::string& path, Clock::time_point detected)>;
+
+    AssetWatcher();
+    ~AssetWatcher();
+
+    AssetWatcher(const AssetWatcher&) = delete;
+    AssetWatcher& operator=(const AssetWatcher&) = delete;
+
+    // `changed` roda dentro de poll() com o caminho registrado e o instante em
+    // que a mudança foi vista, para medir a latência da recarga
+    bool watch(const std::string& path, Callback changed);
+
+    // Chamar uma vez por quadro; não bloqueia. Várias gravações do mesmo
+    // arquivo no mesmo quadro geram uma única chamada. Retorna quantas houve.
+    size_t poll();
+
+    std::chrono::milliseconds pollInterval{500};
+
+private:
+    struct Entry
+    {
+        std::string path;
+        std::string directory;
+        std::string name;
+        int watchId = -1;
+        int64_t lastWrite = 0;
+        Callback changed;
+    };
+
+    std::vector<Entry> entries;
+    int inotifyFd = -1;
+    Clock::time_point lastScan = Clock::now();
+};
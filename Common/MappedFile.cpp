@@ -0,0 +1,152 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        ptr = other.ptr;
+        len = other.len;
+        opened = other.opened;
+#ifdef _WIN32
+        fileHandle = other.fileHandle;
+        mappingHandle = other.mappingHandle;
+        other.fileHandle = nullptr;
+        other.mappingHandle = nullptr;
+#endif
+        other.ptr = nullptr;
+        other.len = 0;
+        other.opened = false;
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path)
+{
+    close();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // Arquivo vazio: não há o que mapear, mas a abertura é válida
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        opened = true;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    ptr = static_cast<const char*>(view);
+    len = static_cast<size_t>(fileSize.QuadPart);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (ptr)
+        UnmapViewOfFile(ptr);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+    ptr = nullptr;
+    len = 0;
+    opened = false;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const char* path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Arquivo vazio: mmap com tamanho 0 falha, mas a abertura é válida
+    if (st.st_size == 0) {
+        ::close(fd);
+        opened = true;
+        return true;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // O mapeamento continua válido depois de fechar o descritor
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    // Os parsers percorrem o arquivo do início ao fim uma única vez
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    ptr = static_cast<const char*>(view);
+    len = static_cast<size_t>(st.st_size);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (ptr)
+        munmap(const_cast<char*>(ptr), len);
+    ptr = nullptr;
+    len = 0;
+    opened = false;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// Arquivo mapeado em memória somente para leitura (mmap no Linux/macOS,
+// CreateFileMapping no Windows). O conteúdo fica acessível em data()/size()
+// enquanto o objeto existir, sem nenhuma cópia para o heap.
+struct MappedFile
+{
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const char* path);
+    void close();
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool isOpen() const { return opened; }
+
+private:
+    const char* ptr = nullptr;
+    size_t len = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,76 @@
+#include "Material.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+bool loadMTL(const char* path, vector<Material>& out)
+{
+    ifstream file(path);
+    if (!file.is_open()) {
+        cout << "Erro ao abrir arquivo MTL: " << path << endl;
+        return false;
+    }
+
+    filesystem::path directory = filesystem::path(path).parent_path();
+    out.clear();
+
+    string line;
+    while (getline(file, line)) {
+        istringstream iss(line);
+        string token;
+        iss >> token;
+
+        if (token == "newmtl") {
+            out.emplace_back();
+            iss >> out.back().name;
+            continue;
+        }
+        if (token.empty() || token[0] == '#')
+            continue;
+
+        // Propriedades antes do primeiro newmtl formam um material sem nome
+        if (out.empty())
+            out.emplace_back();
+        Material& material = out.back();
+
+        if (token == "Ka")
+            iss >> material.ka.x >> material.ka.y >> material.ka.z;
+        else if (token == "Kd")
+            iss >> material.kd.x >> material.kd.y >> material.kd.z;
+        else if (token == "Ks")
+            iss >> material.ks.x >> material.ks.y >> material.ks.z;
+        else if (token == "Ns")
+            iss >> material.ns;
+        else if (token == "map_Kd") {
+            // Opções como "-s 1 1 1" vêm antes; o arquivo é a última palavra
+            string file;
+            while (iss >> token)
+                file = token;
+            if (!file.empty())
+                material.diffuseMap = (directory / file).string();
+        }
+    }
+
+    cout << "MTL carregado: " << path << " (" << out.size() << " materiais)" << endl;
+    return true;
+}
+
+vector<int> resolveMaterials(const vector<Material>& library, const vector<string>& names)
+{
+    vector<int> indices(names.size(), -1);
+    for (size_t i = 0; i < names.size(); i++) {
+        for (size_t m = 0; m < library.size(); m++) {
+            if (library[m].name == names[i]) {
+                indices[i] = (int)m;
+                break;
+            }
+        }
+        if (indices[i] < 0)
+            cout << "Material não encontrado no MTL: " << names[i] << endl;
+    }
+    return indices;
+}
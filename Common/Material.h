@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Material de um .mtl: coeficientes de Phong e textura difusa
+struct Material
+{
+    std::string name;
+    glm::vec3 ka = glm::vec3(0.2f); // Ambiente
+    glm::vec3 kd = glm::vec3(0.8f); // Difuso
+    glm::vec3 ks = glm::vec3(1.0f); // Especular
+    float ns = 64.0f;               // Shininess
+    std::string diffuseMap;         // map_Kd já com o diretório do .mtl; vazio = sem textura
+
+    // Posição do map_Kd em um TextureArraySet (ver assignTextureLayer); -1 = ainda não empacotada
+    int diffuseArray = -1;
+    int diffuseLayer = 0;
+};
+
+// Lê todos os "newmtl" de um .mtl com Ka, Kd, Ks, Ns e map_Kd; o que não
+// aparece no arquivo fica com o valor padrão de Material
+bool loadMTL(const char* path, std::vector<Material>& out);
+
+// Posição em `library` de cada nome de `names` (-1 = não encontrado), para
+// traduzir MeshRange::material em um material lido do .mtl
+std::vector<int> resolveMaterials(const std::vector<Material>& library, const std::vector<std::string>& names);
@@ -0,0 +1,440 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+static_assert(sizeof(MeshVertex) == 11 * sizeof(GLfloat), "MeshVertex deve ter 11 floats sem padding");
+
+namespace {
+
+bool isFloatFormat(const VertexFormat& f)
+{
+    return f.position == POSITION_FLOAT && f.color != COLOR_UNORM8 && f.normal == NORMAL_FLOAT && f.uv == UV_FLOAT;
+}
+
+// Mapeia `buffer` só para escrita, descartando o conteúdo anterior, e passa
+// o ponteiro para `write`. Se o driver perder o conteúdo antes do unmap
+// (glUnmapBuffer devolve GL_FALSE), tenta mapear mais uma vez. Se o
+// mapeamento falhar ou a segunda escrita também se perder, `write` escreve em
+// um vetor temporário enviado com glBufferSubData.
+template <typename Write>
+void writeMappedBuffer(GLuint buffer, size_t size, Write write)
+{
+    if (size == 0)
+        return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    bool written = false;
+    for (int attempt = 0; attempt < 2 && !written; attempt++) {
+        void* dst = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!dst) {
+            cout << "glMapBufferRange falhou (erro 0x" << hex << glGetError() << dec << ", " << size
+                 << " bytes); enviando por glBufferSubData" << endl;
+            break;
+        }
+        write(dst);
+        written = glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE;
+    }
+    if (!written) {
+        vector<uint8_t> staging(size);
+        write(staging.data());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, staging.data());
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Escreve os índices no EBO já alocado, convertendo para 16 bits se for o caso
+void writeMeshIndices(const GpuMesh& gpu, const vector<uint32_t>& indices)
+{
+    if (gpu.indexType == GL_UNSIGNED_SHORT) {
+        writeMappedBuffer(gpu.EBO, indices.size() * sizeof(uint16_t), [&](void* dst) {
+            uint16_t* out = static_cast<uint16_t*>(dst);
+            for (size_t i = 0; i < indices.size(); i++)
+                out[i] = (uint16_t)indices[i];
+        });
+    }
+    else {
+        writeMappedBuffer(gpu.EBO, indices.size() * sizeof(uint32_t),
+                          [&](void* dst) { memcpy(dst, indices.data(), indices.size() * sizeof(uint32_t)); });
+    }
+}
+
+void drawIndices(const GpuMesh& mesh, uint32_t firstIndex, uint32_t indexCount)
+{
+    size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    glDrawElements(GL_TRIANGLES, indexCount, mesh.indexType, (GLvoid*)(uintptr_t)(firstIndex * indexSize));
+}
+
+// Tabela hash de endereçamento aberto que mapeia (v, vt, vn) -> índice do vértice.
+// Guarda apenas índice + 1 (0 = vazio); a chave é lida do vetor `keys`.
+struct CornerTable
+{
+    vector<uint32_t> slots;
+    vector<ObjIndex> keys;
+    size_t mask = 0;
+
+    explicit CornerTable(size_t expected)
+    {
+        size_t capacity = 64;
+        while (capacity < expected * 2)
+            capacity *= 2;
+        slots.assign(capacity, 0);
+        mask = capacity - 1;
+        keys.reserve(expected);
+    }
+
+    static size_t hash(const ObjIndex& k)
+    {
+        uint64_t h = (uint64_t)(uint32_t)k.v * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)(uint32_t)k.vt * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+        h ^= (uint64_t)(uint32_t)k.vn * 0x165667B19E3779F9ull + (h >> 32);
+        return (size_t)(h ^ (h >> 31));
+    }
+
+    static bool equal(const ObjIndex& a, const ObjIndex& b)
+    {
+        return a.v == b.v && a.vt == b.vt && a.vn == b.vn;
+    }
+
+    void grow()
+    {
+        vector<uint32_t> old(slots.size() * 2, 0);
+        slots.swap(old);
+        mask = slots.size() - 1;
+        for (uint32_t id : old) {
+            if (!id)
+                continue;
+            size_t i = hash(keys[id - 1]) & mask;
+            while (slots[i])
+                i = (i + 1) & mask;
+            slots[i] = id;
+        }
+    }
+
+    // Retorna o índice do vértice da chave; `inserted` indica se é novo
+    uint32_t findOrInsert(const ObjIndex& key, bool& inserted)
+    {
+        size_t i = hash(key) & mask;
+        while (slots[i]) {
+            if (equal(keys[slots[i] - 1], key)) {
+                inserted = false;
+                return slots[i] - 1;
+            }
+            i = (i + 1) & mask;
+        }
+
+        inserted = true;
+        keys.push_back(key);
+        slots[i] = (uint32_t)keys.size();
+        if (keys.size() * 2 > slots.size())
+            grow();
+        return (uint32_t)keys.size() - 1;
+    }
+};
+
+} // namespace
+
+void buildIndexedMesh(const ObjData& obj, IndexedMesh& out)
+{
+    size_t corners = obj.corners.size();
+    size_t triangles = corners / 3;
+    out.vertices.clear();
+    out.hasColors = !obj.colors.empty();
+    out.indices.resize(corners);
+    out.ranges.clear();
+    out.materials = obj.materials;
+    out.materialLibrary = obj.materialLibs.empty() ? string() : obj.materialLibs[0];
+
+    // Ordem dos triângulos: grupos com o mesmo (material, objeto) juntos, em
+    // ordem de material e, dentro dele, na ordem do arquivo
+    vector<ObjGroup> keys;
+    vector<uint32_t> groupKey(obj.groups.size());
+    for (size_t g = 0; g < obj.groups.size(); g++) {
+        const ObjGroup& group = obj.groups[g];
+        auto same = [&](const ObjGroup& k) { return k.material == group.material && k.object == group.object; };
+        size_t k = find_if(keys.begin(), keys.end(), same) - keys.begin();
+        if (k == keys.size())
+            keys.push_back(group);
+        groupKey[g] = (uint32_t)k;
+    }
+    vector<uint32_t> keyOrder(keys.size());
+    for (size_t k = 0; k < keyOrder.size(); k++)
+        keyOrder[k] = (uint32_t)k;
+    stable_sort(keyOrder.begin(), keyOrder.end(),
+                [&](uint32_t a, uint32_t b) { return keys[a].material < keys[b].material; });
+
+    vector<uint32_t> order;
+    if (keys.size() > 1) {
+        vector<vector<uint32_t>> keyGroups(keys.size());
+        for (size_t g = 0; g < obj.groups.size(); g++)
+            keyGroups[groupKey[g]].push_back((uint32_t)g);
+
+        order.reserve(triangles);
+        for (uint32_t k : keyOrder) {
+            uint32_t first = (uint32_t)order.size();
+            for (uint32_t g : keyGroups[k]) {
+                uint32_t begin = obj.groups[g].firstTriangle;
+                uint32_t end = g + 1 < obj.groups.size() ? obj.groups[g + 1].firstTriangle : (uint32_t)triangles;
+                for (uint32_t t = begin; t < end; t++)
+                    order.push_back(t);
+            }
+            if (order.size() > first)
+                out.ranges.push_back(MeshRange{ first * 3, ((uint32_t)order.size() - first) * 3, keys[k].material,
+                                                keys[k].object, glm::vec3(0.0f), glm::vec3(0.0f) });
+        }
+    }
+    else {
+        int32_t material = keys.empty() ? -1 : keys[0].material;
+        int32_t object = keys.empty() ? -1 : keys[0].object;
+        out.ranges.push_back(MeshRange{ 0, (uint32_t)corners, material, object, glm::vec3(0.0f), glm::vec3(0.0f) });
+    }
+
+    // O número de vértices únicos costuma ficar próximo do número de posições
+    CornerTable table(max(obj.positions.size(), obj.normals.size()));
+    out.vertices.reserve(max(obj.positions.size(), obj.normals.size()));
+
+    for (size_t i = 0; i < triangles; i++) {
+        size_t t = (order.empty() ? i : order[i]) * 3;
+        const ObjIndex* c = &obj.corners[t];
+        bool anyFlat = c[0].vn < 0 || c[1].vn < 0 || c[2].vn < 0;
+        glm::vec3 faceNormal = anyFlat ? objFaceNormal(obj, c) : glm::vec3(0.0f);
+
+        for (int k = 0; k < 3; k++) {
+            ObjIndex key = c[k];
+            // Canto sem vn: normal de face, com chave exclusiva do triângulo
+            // (sem compartilhamento); os cantos com vn ficam com a deles
+            bool flat = c[k].vn < 0;
+            if (flat)
+                key.vn = -2 - (int)(t / 3);
+
+            bool inserted;
+            uint32_t id = table.findOrInsert(key, inserted);
+            if (inserted) {
+                MeshVertex vertex;
+                vertex.position = obj.positions[c[k].v];
+                vertex.color = out.hasColors ? obj.colors[c[k].v] : glm::vec3(1.0f);
+                vertex.normal = flat ? faceNormal : obj.normals[c[k].vn];
+                vertex.uv = c[k].vt >= 0 ? obj.uvs[c[k].vt] : glm::vec2(0.0f);
+                out.vertices.push_back(vertex);
+            }
+            out.indices[i * 3 + k] = id;
+        }
+    }
+
+    computeMeshBounds(out);
+
+    if (corners > 0) {
+        cout << "Malha indexada: " << out.vertices.size() << " vértices únicos para "
+             << corners << " cantos (" << (double)corners / out.vertices.size() << "x menos)";
+        if (out.ranges.size() > 1)
+            cout << ", " << out.ranges.size() << " faixas com " << out.materials.size() << " materiais";
+        cout << endl;
+    }
+}
+
+void computeMeshBounds(IndexedMesh& mesh)
+{
+    if (mesh.vertices.empty()) {
+        mesh.boundsMin = mesh.boundsMax = glm::vec3(0.0f);
+        return;
+    }
+
+    mesh.boundsMin = mesh.boundsMax = mesh.vertices[0].position;
+    for (const MeshVertex& v : mesh.vertices) {
+        mesh.boundsMin = glm::min(mesh.boundsMin, v.position);
+        mesh.boundsMax = glm::max(mesh.boundsMax, v.position);
+    }
+
+    // Só as faixas do nível 0; as dos LODs herdam a caixa da faixa de origem
+    size_t rangeCount = mesh.lods.empty() ? mesh.ranges.size() : mesh.lods[0].rangeCount;
+    for (size_t r = 0; r < rangeCount; r++) {
+        MeshRange& range = mesh.ranges[r];
+        if (range.indexCount == 0) {
+            range.boundsMin = range.boundsMax = glm::vec3(0.0f);
+            continue;
+        }
+        range.boundsMin = range.boundsMax = mesh.vertices[mesh.indices[range.firstIndex]].position;
+        for (uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; i++) {
+            const glm::vec3& p = mesh.vertices[mesh.indices[i]].position;
+            range.boundsMin = glm::min(range.boundsMin, p);
+            range.boundsMax = glm::max(range.boundsMax, p);
+        }
+    }
+}
+
+VertexFormat encodeMesh(const IndexedMesh& mesh, const VertexFormat& requested, vector<uint8_t>& out, Dequantization& dequant)
+{
+    VertexFormat format = resolveVertexFormat(requested, mesh.hasColors);
+    VertexLayout layout = makeVertexLayout(format);
+    dequant = computeDequantization(mesh.vertices.data(), mesh.vertices.size(), format);
+    out.resize(vertexBufferSize(layout, mesh.vertices.size()));
+    encodeVertices(mesh.vertices.data(), mesh.vertices.size(), format, dequant, out.data());
+
+    if (!isFloatFormat(format) && !mesh.vertices.empty()) {
+        VertexErrorStats error = measureVertexError(mesh.vertices.data(), mesh.vertices.size(), format, dequant, out.data());
+        cout << "Vértices compactados: " << sizeof(MeshVertex) << " -> " << layout.vertexSize << " bytes ("
+             << (float)sizeof(MeshVertex) / layout.vertexSize << "x menor, "
+             << layout.strides[STREAM_POSITION] << " só de posição); erro máximo: posição "
+             << error.position << " (" << error.positionRel * 100.0f << "% da malha), normal "
+             << error.normalDegrees << " graus, UV " << error.uv << endl;
+    }
+    return format;
+}
+
+GpuMesh uploadMesh(const IndexedMesh& mesh, const VertexFormat& requested)
+{
+    // Sem cópia intermediária: VBO e EBO são alocados no tamanho final e a
+    // codificação dos vértices e a conversão dos índices escrevem direto na
+    // memória mapeada
+    VertexFormat format = resolveVertexFormat(requested, mesh.hasColors);
+    Dequantization dequant = computeDequantization(mesh.vertices.data(), mesh.vertices.size(), format);
+    GLenum indexType = mesh.vertices.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    GpuMesh gpu = uploadMeshData(nullptr, mesh.vertices.size(), format, dequant, nullptr, mesh.indices.size(), indexType);
+
+    writeMappedBuffer(gpu.VBO, vertexBufferSize(makeVertexLayout(format), mesh.vertices.size()), [&](void* dst) {
+        encodeVertices(mesh.vertices.data(), mesh.vertices.size(), format, dequant, dst);
+    });
+    writeMeshIndices(gpu, mesh.indices);
+
+    gpu.ranges = mesh.ranges;
+    gpu.lods = mesh.lods;
+    gpu.meshlets = mesh.meshlets;
+    gpu.materials = mesh.materials;
+    gpu.materialLibrary = mesh.materialLibrary;
+    return gpu;
+}
+
+GpuMesh uploadMeshData(const void* vertices, size_t vertexCount, const VertexFormat& format, const Dequantization& dequant,
+                       const void* indices, size_t indexCount, GLenum indexType)
+{
+    VertexLayout layout = makeVertexLayout(format);
+
+    GpuMesh gpu;
+    gpu.format = format;
+    gpu.dequant = dequant;
+    glGenBuffers(1, &gpu.VBO);
+    glGenBuffers(1, &gpu.EBO);
+
+    // Um único VBO com os fluxos em sequência e um EBO compartilhado
+    glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexBufferSize(layout, vertexCount), vertices, GL_STATIC_DRAW);
+
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexSize, indices, GL_STATIC_DRAW);
+    gpu.indexType = indexType;
+    gpu.indexCount = (GLsizei)indexCount;
+
+    createMeshVertexArrays(gpu, vertexCount);
+    return gpu;
+}
+
+void createMeshVertexArrays(GpuMesh& gpu, size_t vertexCount)
+{
+    VertexLayout layout = makeVertexLayout(gpu.format);
+    glGenVertexArrays(1, &gpu.VAO);
+    glGenVertexArrays(1, &gpu.positionVAO);
+
+    // Cada VAO liga só os fluxos da sua passada; o EBO fica registrado em
+    // cada um, por isso é vinculado com o VAO ativo
+    glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+    glBindVertexArray(gpu.VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.EBO);
+    applyVertexLayout(layout, vertexCount, STREAMS_ALL);
+
+    glBindVertexArray(gpu.positionVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.EBO);
+    applyVertexLayout(layout, vertexCount, STREAMS_POSITION);
+
+    glBindVertexArray(0);
+}
+
+void setMeshUniforms(GLuint program, const GpuMesh& mesh)
+{
+    glUniform3fv(glGetUniformLocation(program, "posScale"), 1, &mesh.dequant.posScale.x);
+    glUniform3fv(glGetUniformLocation(program, "posOffset"), 1, &mesh.dequant.posOffset.x);
+    glUniform2fv(glGetUniformLocation(program, "uvScale"), 1, &mesh.dequant.uvScale.x);
+    glUniform2fv(glGetUniformLocation(program, "uvOffset"), 1, &mesh.dequant.uvOffset.x);
+    glUniform1i(glGetUniformLocation(program, "octNormals"), mesh.format.normal == NORMAL_OCT16);
+}
+
+MeshLod meshLod(const GpuMesh& mesh, int level)
+{
+    if (mesh.lods.empty())
+        return MeshLod{ 0, (uint32_t)mesh.indexCount, 0, 0, 0.0f };
+    level = glm::clamp(level, 0, (int)mesh.lods.size() - 1);
+    return mesh.lods[level];
+}
+
+int selectMeshLod(const GpuMesh& mesh, float distance, float scale, float pixelsPerUnit, float maxPixelError)
+{
+    int level = 0;
+    float pixelsPerObjectUnit = scale * pixelsPerUnit / max(distance, 1e-4f);
+    for (int i = 1; i < (int)mesh.lods.size(); i++)
+        if (mesh.lods[i].error * pixelsPerObjectUnit <= maxPixelError)
+            level = i;
+    return level;
+}
+
+const MeshRange* meshLodRanges(const GpuMesh& mesh, int level, size_t& count)
+{
+    if (mesh.lods.empty()) {
+        count = mesh.ranges.size();
+        return mesh.ranges.data();
+    }
+    MeshLod lod = meshLod(mesh, level);
+    count = lod.rangeCount;
+    return mesh.ranges.data() + lod.firstRange;
+}
+
+void drawMesh(const GpuMesh& mesh, int level, const MaterialBinder& bindMaterial)
+{
+    glBindVertexArray(mesh.VAO);
+    // Sem fluxo de cor, o atributo 1 desabilitado lê este valor constante
+    if (mesh.format.color == COLOR_NONE)
+        glVertexAttrib4f(1, mesh.color.r, mesh.color.g, mesh.color.b, 1.0f);
+
+    size_t count;
+    const MeshRange* ranges = meshLodRanges(mesh, level, count);
+    if (!bindMaterial || count == 0) {
+        if (bindMaterial)
+            bindMaterial(-1);
+        MeshLod lod = meshLod(mesh, level);
+        drawIndices(mesh, lod.firstIndex, lod.indexCount);
+    }
+    else {
+        // Faixas do mesmo material são vizinhas no EBO e saem juntas
+        for (size_t r = 0; r < count;) {
+            size_t next = r + 1;
+            uint32_t end = ranges[r].firstIndex + ranges[r].indexCount;
+            while (next < count && ranges[next].material == ranges[r].material && ranges[next].firstIndex == end) {
+                end += ranges[next].indexCount;
+                ++next;
+            }
+            bindMaterial(ranges[r].material);
+            drawIndices(mesh, ranges[r].firstIndex, end - ranges[r].firstIndex);
+            r = next;
+        }
+    }
+    glBindVertexArray(0);
+}
+
+void drawMeshPositions(const GpuMesh& mesh, int level)
+{
+    glBindVertexArray(mesh.positionVAO);
+    MeshLod lod = meshLod(mesh, level);
+    drawIndices(mesh, lod.firstIndex, lod.indexCount);
+    glBindVertexArray(0);
+}
+
+void deleteMesh(GpuMesh& mesh)
+{
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteVertexArrays(1, &mesh.positionVAO);
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    mesh = GpuMesh();
+}
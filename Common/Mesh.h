@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ObjLoader.h"
+#include "VertexFormat.h"
+
+// Vértice de trabalho na CPU, em float: posição (location 0), cor (1),
+// normal (2) e UV (3). O layout enviado à GPU é escolhido por VertexFormat.
+struct MeshVertex
+{
+    glm::vec3 position;
+    glm::vec3 color;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+// Faixa contígua de índices desenhada com um mesmo material: os triângulos
+// de um par (usemtl, o/g) do OBJ. As faixas de um nível vêm ordenadas por
+// material, então cada troca de material acontece uma única vez por nível.
+struct MeshRange
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t material; // índice em `materials` da malha; -1 = material padrão
+    int32_t object;   // grupo "o"/"g" de origem; -1 = nenhum
+    glm::vec3 boundsMin; // caixa envolvente dos triângulos do nível 0
+    glm::vec3 boundsMax;
+};
+
+// Nível de detalhe: um trecho dos índices (e das faixas de material) que
+// desenha a malha com menos triângulos sobre os mesmos vértices
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t firstRange;
+    uint32_t rangeCount;
+    float error; // maior desvio geométrico em relação ao nível 0, em unidades do objeto
+};
+
+// Meshlet: trecho contíguo dos índices do nível 0 com esfera envolvente e cone
+// de normais, para descartar grupos fora da tela ou de costas na CPU
+struct Meshlet
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneApex;
+    glm::vec3 coneAxis;
+    float coneCutoff; // seno da abertura; 1 = nunca descartado pelo cone
+};
+
+// Malha indexada: cada combinação única (v, vt, vn) do OBJ vira um único vértice
+struct IndexedMesh
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices; // 3 por triângulo
+    std::vector<MeshRange> ranges;
+    std::vector<MeshLod> lods;     // vazio = só a malha original
+    std::vector<Meshlet> meshlets; // sobre o nível 0; vazio = sem divisão
+    std::vector<std::string> materials; // nomes de material referidos por MeshRange::material
+    std::string materialLibrary;        // "mtllib" do OBJ, relativo ao diretório dele
+    bool hasColors = false; // cor por vértice vinda da origem
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+// Malha já enviada para a GPU. O VBO guarda os fluxos de vértices em sequência
+// (ver VertexStream): `VAO` liga todos e `positionVAO` só o de posição.
+struct GpuMesh
+{
+    GLuint VAO = 0;
+    GLuint positionVAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    VertexFormat format;
+    Dequantization dequant;
+    glm::vec3 color = glm::vec3(1.0f); // cor constante quando não há fluxo de cor
+    std::vector<MeshRange> ranges;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    std::vector<std::string> materials;
+    std::string materialLibrary; // .mtl resolvido ao lado do .obj nas cargas por arquivo; como
+                                 // veio no "mtllib" quando enviada de uma IndexedMesh
+};
+
+// Chamada no desenho sempre que o material muda, com MeshRange::material,
+// para o programa ligar uniforms e texturas só nessas trocas
+using MaterialBinder = std::function<void(int32_t material)>;
+
+// Remove os cantos repetidos do OBJ por meio de uma tabela hash de (v, vt, vn).
+// Cantos sem normal usam a normal da face e por isso não são compartilhados.
+// A cor por vértice só é preenchida quando o OBJ a traz (ObjData::colors).
+// Os triângulos são agrupados por (material, objeto), em ordem de material,
+// e cada grupo vira uma MeshRange.
+void buildIndexedMesh(const ObjData& obj, IndexedMesh& out);
+
+// Caixa envolvente alinhada aos eixos dos vértices da malha e de cada faixa
+void computeMeshBounds(IndexedMesh& mesh);
+
+// Codifica os vértices no formato pedido e, para formatos compactos, imprime
+// o tamanho por vértice e o maior erro de reconstrução. Retorna o formato
+// efetivo (sem fluxo de cor quando a malha não tem cor por vértice).
+VertexFormat encodeMesh(const IndexedMesh& mesh, const VertexFormat& format, std::vector<uint8_t>& out, Dequantization& dequant);
+
+// Cria VAO/VBO/EBO; usa índices de 16 bits quando a malha tem até 65536 vértices.
+// Os vértices são codificados direto no VBO mapeado com glMapBufferRange, sem
+// vetor intermediário do tamanho da malha (salvo se o mapeamento falhar: aí
+// passam por um vetor e glBufferSubData).
+GpuMesh uploadMesh(const IndexedMesh& mesh, const VertexFormat& format = VERTEX_FORMAT_FLOAT);
+
+// Cria VAO/VBO/EBO a partir de buffers já no formato final (vértices
+// codificados e índices de 16 ou 32 bits), por exemplo direto de um arquivo mapeado
+GpuMesh uploadMeshData(const void* vertices, size_t vertexCount, const VertexFormat& format, const Dequantization& dequant,
+                       const void* indices, size_t indexCount, GLenum indexType);
+
+// Cria os dois VAOs (todos os fluxos e só posição) sobre gpu.VBO e gpu.EBO já
+// existentes. VAOs não são compartilhados entre contextos, então buffers
+// criados em um contexto de envio ganham os VAOs no contexto que desenha.
+void createMeshVertexArrays(GpuMesh& gpu, size_t vertexCount);
+
+// Envia ao programa em uso os uniforms de dequantização da malha
+// (posScale, posOffset, uvScale, uvOffset e octNormals)
+void setMeshUniforms(GLuint program, const GpuMesh& mesh);
+
+// Nível de detalhe `level` (limitado aos níveis existentes); sem cadeia de
+// LOD, o nível 0 cobre todos os índices
+MeshLod meshLod(const GpuMesh& mesh, int level);
+
+// Nível mais simples cujo erro, projetado na tela, fica abaixo de
+// `maxPixelError`. `distance` e `scale` levam o erro do espaço do objeto para
+// o da câmera; `pixelsPerUnit` = altura da tela / (2 * tan(fovY / 2)).
+int selectMeshLod(const GpuMesh& mesh, float distance, float scale, float pixelsPerUnit, float maxPixelError = 1.0f);
+
+// Faixas do nível `level`; sem cadeia de LOD, todas as faixas da malha
+const MeshRange* meshLodRanges(const GpuMesh& mesh, int level, size_t& count);
+
+// Desenha com todos os fluxos, definindo antes a cor constante se for o caso.
+// Com `bindMaterial`, faixas vizinhas do mesmo material saem em um único
+// glDrawElements e o callback roda só quando o material muda.
+void drawMesh(const GpuMesh& mesh, int level = 0, const MaterialBinder& bindMaterial = nullptr);
+
+// Desenha lendo só o fluxo de posição (passadas de profundidade)
+void drawMeshPositions(const GpuMesh& mesh, int level = 0);
+void deleteMesh(GpuMesh& mesh);
@@ -0,0 +1,388 @@
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static_assert(sizeof(MeshCacheHeader) == 184, "MeshCacheHeader não pode ter padding");
+static_assert(sizeof(MeshRange) == 40, "MeshRange não pode ter padding");
+static_assert(sizeof(MeshLod) == 20, "MeshLod não pode ter padding");
+static_assert(sizeof(Meshlet) == 52, "Meshlet não pode ter padding");
+
+namespace {
+
+const char MESH_CACHE_MAGIC[4] = { 'C', 'G', 'M', 'C' };
+
+uint64_t alignTo16(uint64_t offset)
+{
+    return (offset + 15) & ~uint64_t(15);
+}
+
+// Versão das etapas de otimização; mudar invalida os caches já gravados
+const uint32_t MESH_OPTIMIZER_VERSION = 5;
+
+// Chave das opções de montagem da malha: formato do vértice, otimizador, LODs e meshlets
+uint64_t meshBuildKey(const VertexFormat& format)
+{
+    uint32_t packed = packVertexFormat(format);
+    uint64_t key = hashBytes(&packed, sizeof(packed));
+    key = hashBytes(&MESH_OPTIMIZER_VERSION, sizeof(MESH_OPTIMIZER_VERSION), key);
+    key = hashBytes(&OVERDRAW_THRESHOLD, sizeof(OVERDRAW_THRESHOLD), key);
+    key = hashBytes(&MAX_LOD_LEVELS, sizeof(MAX_LOD_LEVELS), key);
+    key = hashBytes(&LOD_MAX_ERROR, sizeof(LOD_MAX_ERROR), key);
+    key = hashBytes(&MESHLET_MAX_VERTICES, sizeof(MESHLET_MAX_VERTICES), key);
+    return hashBytes(&MESHLET_MAX_TRIANGLES, sizeof(MESHLET_MAX_TRIANGLES), key);
+}
+
+// Os trechos (faixas, LODs ou meshlets) cabem nos `indexCount` índices?
+template <typename Span>
+bool spansFit(const Span* spans, uint32_t count, uint32_t indexCount)
+{
+    for (uint32_t i = 0; i < count; i++)
+        if ((uint64_t)spans[i].firstIndex + spans[i].indexCount > indexCount)
+            return false;
+    return true;
+}
+
+// Todos os índices apontam para vértices existentes?
+template <typename Index>
+bool indicesFit(const void* data, uint32_t indexCount, uint32_t vertexCount)
+{
+    const Index* indices = static_cast<const Index*>(data);
+    for (uint32_t i = 0; i < indexCount; i++)
+        if (indices[i] >= vertexCount)
+            return false;
+    return true;
+}
+
+} // namespace
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool readSourceStamp(const char* path, SourceStamp& stamp)
+{
+    error_code ec;
+    uintmax_t size = fs::file_size(path, ec);
+    if (ec)
+        return false;
+    fs::file_time_type time = fs::last_write_time(path, ec);
+    if (ec)
+        return false;
+
+    stamp.size = size;
+    stamp.time = (int64_t)time.time_since_epoch().count();
+    return true;
+}
+
+string uniqueTempPath(const string& path)
+{
+    static atomic<unsigned> counter{ 0 };
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = (int)getpid();
+#endif
+    ostringstream name;
+    name << path << '.' << pid << '-' << hash<thread::id>()(this_thread::get_id()) << '-' << counter++ << ".tmp";
+    return name.str();
+}
+
+string meshCachePath(const char* sourcePath)
+{
+    return string(sourcePath) + ".meshcache";
+}
+
+bool openMeshCache(const char* cachePath, const SourceStamp& stamp, uint64_t buildKey, MeshCacheView& view)
+{
+    if (!view.file.open(cachePath) || view.file.size() < sizeof(MeshCacheHeader))
+        return false;
+
+    const char* base = view.file.data();
+    const MeshCacheHeader* h = reinterpret_cast<const MeshCacheHeader*>(base);
+
+    if (memcmp(h->magic, MESH_CACHE_MAGIC, 4) != 0 || h->version != MESH_CACHE_VERSION)
+        return false;
+    if (h->sourceSize != stamp.size || h->sourceTime != stamp.time || h->buildKey != buildKey)
+        return false;
+    VertexLayout layout = makeVertexLayout(unpackVertexFormat(h->vertexFormat));
+    if (h->vertexStride != (uint32_t)layout.vertexSize || (h->indexSize != 2 && h->indexSize != 4))
+        return false;
+
+    uint64_t size = view.file.size();
+    if (h->vertexOffset + vertexBufferSize(layout, h->vertexCount) > size ||
+        h->indexOffset + (uint64_t)h->indexCount * h->indexSize > size ||
+        h->rangeOffset + (uint64_t)h->rangeCount * sizeof(MeshRange) > size ||
+        h->lodOffset + (uint64_t)h->lodCount * sizeof(MeshLod) > size ||
+        h->meshletOffset + (uint64_t)h->meshletCount * sizeof(Meshlet) > size ||
+        h->nameOffset + h->nameBytes > size)
+        return false;
+
+    // Nomes: o mtllib e depois um por material, cada um terminado em zero
+    const char* name = base + h->nameOffset;
+    const char* namesEnd = name + h->nameBytes;
+    vector<string> names;
+    while (name < namesEnd) {
+        const char* nul = static_cast<const char*>(memchr(name, 0, namesEnd - name));
+        if (!nul)
+            return false;
+        names.emplace_back(name, nul);
+        name = nul + 1;
+    }
+    if (names.size() != (size_t)h->materialCount + 1)
+        return false;
+
+    // Um cache corrompido com o cabeçalho válido faria o desenho ler fora dos
+    // buffers: os trechos, os materiais e os índices também são conferidos
+    const MeshRange* ranges = reinterpret_cast<const MeshRange*>(base + h->rangeOffset);
+    const MeshLod* lods = reinterpret_cast<const MeshLod*>(base + h->lodOffset);
+    const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(base + h->meshletOffset);
+    if (!spansFit(ranges, h->rangeCount, h->indexCount) || !spansFit(lods, h->lodCount, h->indexCount) ||
+        !spansFit(meshlets, h->meshletCount, h->indexCount))
+        return false;
+    for (uint32_t i = 0; i < h->lodCount; i++)
+        if ((uint64_t)lods[i].firstRange + lods[i].rangeCount > h->rangeCount)
+            return false;
+    for (uint32_t i = 0; i < h->rangeCount; i++)
+        if (ranges[i].material < -1 || ranges[i].material >= (int32_t)h->materialCount)
+            return false;
+    const void* indices = base + h->indexOffset;
+    if (h->indexSize == 2 ? !indicesFit<uint16_t>(indices, h->indexCount, h->vertexCount)
+                          : !indicesFit<uint32_t>(indices, h->indexCount, h->vertexCount))
+        return false;
+
+    view.materialLibrary = names[0];
+    view.materials.assign(names.begin() + 1, names.end());
+
+    view.header = h;
+    view.vertices = base + h->vertexOffset;
+    view.indices = indices;
+    view.ranges = ranges;
+    view.lods = lods;
+    view.meshlets = meshlets;
+    return true;
+}
+
+bool writeMeshCache(const char* cachePath, const SourceStamp& stamp, uint64_t buildKey, const IndexedMesh& mesh,
+                    const VertexFormat& format, const void* vertices, const Dequantization& dequant)
+{
+    bool shortIndices = mesh.vertices.size() <= 65536;
+
+    MeshCacheHeader h = {};
+    memcpy(h.magic, MESH_CACHE_MAGIC, 4);
+    h.version = MESH_CACHE_VERSION;
+    h.sourceSize = stamp.size;
+    h.sourceTime = stamp.time;
+    h.buildKey = buildKey;
+    VertexLayout layout = makeVertexLayout(format);
+    h.vertexStride = layout.vertexSize;
+    h.vertexCount = (uint32_t)mesh.vertices.size();
+    h.indexSize = shortIndices ? 2 : 4;
+    h.indexCount = (uint32_t)mesh.indices.size();
+    h.rangeCount = (uint32_t)mesh.ranges.size();
+    h.lodCount = (uint32_t)mesh.lods.size();
+    h.meshletCount = (uint32_t)mesh.meshlets.size();
+    h.materialCount = (uint32_t)mesh.materials.size();
+    memcpy(h.boundsMin, &mesh.boundsMin, sizeof(h.boundsMin));
+    memcpy(h.boundsMax, &mesh.boundsMax, sizeof(h.boundsMax));
+    h.vertexFormat = packVertexFormat(format);
+    memcpy(h.posScale, &dequant.posScale, sizeof(h.posScale));
+    memcpy(h.posOffset, &dequant.posOffset, sizeof(h.posOffset));
+    memcpy(h.uvScale, &dequant.uvScale, sizeof(h.uvScale));
+    memcpy(h.uvOffset, &dequant.uvOffset, sizeof(h.uvOffset));
+    h.vertexOffset = alignTo16(sizeof(MeshCacheHeader));
+    h.indexOffset = alignTo16(h.vertexOffset + vertexBufferSize(layout, h.vertexCount));
+    h.rangeOffset = alignTo16(h.indexOffset + (uint64_t)h.indexCount * h.indexSize);
+    h.lodOffset = alignTo16(h.rangeOffset + (uint64_t)h.rangeCount * sizeof(MeshRange));
+    h.meshletOffset = alignTo16(h.lodOffset + (uint64_t)h.lodCount * sizeof(MeshLod));
+    h.nameOffset = alignTo16(h.meshletOffset + (uint64_t)h.meshletCount * sizeof(Meshlet));
+
+    string names = mesh.materialLibrary + '\0';
+    for (const string& material : mesh.materials)
+        names += material + '\0';
+    h.nameBytes = (uint32_t)names.size();
+
+    string tmpPath = uniqueTempPath(cachePath);
+    ofstream out(tmpPath, ios::binary | ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    const char zeros[16] = {};
+    auto padTo = [&](uint64_t offset) {
+        uint64_t pos = (uint64_t)out.tellp();
+        if (offset > pos)
+            out.write(zeros, offset - pos);
+    };
+
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    padTo(h.vertexOffset);
+    out.write(static_cast<const char*>(vertices), vertexBufferSize(layout, h.vertexCount));
+
+    padTo(h.indexOffset);
+    if (shortIndices) {
+        vector<uint16_t> indices16(mesh.indices.begin(), mesh.indices.end());
+        out.write(reinterpret_cast<const char*>(indices16.data()), indices16.size() * sizeof(uint16_t));
+    }
+    else {
+        out.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+    }
+
+    padTo(h.rangeOffset);
+    out.write(reinterpret_cast<const char*>(mesh.ranges.data()), mesh.ranges.size() * sizeof(MeshRange));
+
+    padTo(h.lodOffset);
+    out.write(reinterpret_cast<const char*>(mesh.lods.data()), mesh.lods.size() * sizeof(MeshLod));
+
+    padTo(h.meshletOffset);
+    out.write(reinterpret_cast<const char*>(mesh.meshlets.data()), mesh.meshlets.size() * sizeof(Meshlet));
+
+    padTo(h.nameOffset);
+    out.write(names.data(), names.size());
+
+    out.close();
+    if (!out) {
+        fs::remove(tmpPath);
+        return false;
+    }
+
+    error_code ec;
+    fs::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool prepareMesh(const char* objPath, const VertexFormat& format, PreparedMesh& out,
+                 const MaterialLibraryHook& onMaterialLibrary)
+{
+    auto start = chrono::steady_clock::now();
+
+    SourceStamp stamp;
+    if (!readSourceStamp(objPath, stamp)) {
+        cout << "Erro ao abrir o arquivo OBJ: " << objPath << endl;
+        return false;
+    }
+
+    string cachePath = meshCachePath(objPath);
+    uint64_t buildKey = meshBuildKey(format);
+
+    // O mtllib é relativo ao diretório do .obj
+    fs::path objDirectory = fs::path(objPath).parent_path();
+    auto resolveLibrary = [&](const string& name) { return (objDirectory / name).string(); };
+
+    if (openMeshCache(cachePath.c_str(), stamp, buildKey, out.cache)) {
+        const MeshCacheHeader* h = out.cache.header;
+        out.format = unpackVertexFormat(h->vertexFormat);
+        memcpy(&out.dequant.posScale, h->posScale, sizeof(h->posScale));
+        memcpy(&out.dequant.posOffset, h->posOffset, sizeof(h->posOffset));
+        memcpy(&out.dequant.uvScale, h->uvScale, sizeof(h->uvScale));
+        memcpy(&out.dequant.uvOffset, h->uvOffset, sizeof(h->uvOffset));
+        out.vertices = out.cache.vertices;
+        out.vertexCount = h->vertexCount;
+        out.indices = out.cache.indices;
+        out.indexCount = h->indexCount;
+        out.indexType = h->indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        out.ranges.assign(out.cache.ranges, out.cache.ranges + h->rangeCount);
+        out.lods.assign(out.cache.lods, out.cache.lods + h->lodCount);
+        out.meshlets.assign(out.cache.meshlets, out.cache.meshlets + h->meshletCount);
+        out.materials = out.cache.materials;
+        out.materialLibrary = out.cache.materialLibrary;
+        if (onMaterialLibrary && !out.materialLibrary.empty())
+            onMaterialLibrary(resolveLibrary(out.materialLibrary));
+    }
+    else {
+        ObjLoadOptions options;
+        if (onMaterialLibrary)
+            options.onMaterialLibrary = [&](const string& name) { onMaterialLibrary(resolveLibrary(name)); };
+        ObjData obj;
+        if (!parseOBJ(objPath, obj, options))
+            return false;
+
+        buildIndexedMesh(obj, out.mesh);
+        // ACMR e overdraw só depois dos meshlets, que reordenam os triângulos de novo
+        MeshOrderStats orderBefore = analyzeMeshOrder(out.mesh);
+        reorderMesh(out.mesh);
+        buildMeshlets(out.mesh, objPath);
+        printMeshOrderStats(objPath, orderBefore, analyzeMeshOrder(out.mesh));
+        buildLodChain(out.mesh, objPath);
+
+        out.format = encodeMesh(out.mesh, format, out.encoded, out.dequant);
+
+        if (!writeMeshCache(cachePath.c_str(), stamp, buildKey, out.mesh, out.format, out.encoded.data(), out.dequant))
+            cout << "Não foi possível gravar o cache de malha: " << cachePath << endl;
+
+        out.vertices = out.encoded.data();
+        out.vertexCount = out.mesh.vertices.size();
+        out.indexCount = out.mesh.indices.size();
+        if (out.vertexCount <= 65536) {
+            out.indices16.assign(out.mesh.indices.begin(), out.mesh.indices.end());
+            out.indices = out.indices16.data();
+            out.indexType = GL_UNSIGNED_SHORT;
+        }
+        else {
+            out.indices = out.mesh.indices.data();
+            out.indexType = GL_UNSIGNED_INT;
+        }
+        out.ranges = out.mesh.ranges;
+        out.lods = out.mesh.lods;
+        out.meshlets = out.mesh.meshlets;
+        out.materials = out.mesh.materials;
+        out.materialLibrary = out.mesh.materialLibrary;
+    }
+
+    if (!out.materialLibrary.empty())
+        out.materialLibrary = resolveLibrary(out.materialLibrary);
+
+    out.vertexBytes = vertexBufferSize(makeVertexLayout(out.format), out.vertexCount);
+    out.indexBytes = out.indexCount * (out.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+
+    if (out.cache.header) {
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Malha carregada do cache: " << cachePath << " (" << out.vertexCount << " vértices, "
+             << out.lods.size() << " níveis de detalhe, " << out.meshlets.size() << " meshlets, "
+             << out.materials.size() << " materiais) em " << ms << " ms"
+             << endl;
+    }
+    return true;
+}
+
+GpuMesh uploadPreparedMesh(const PreparedMesh& prepared)
+{
+    GpuMesh gpu = uploadMeshData(prepared.vertices, prepared.vertexCount, prepared.format, prepared.dequant,
+                                 prepared.indices, prepared.indexCount, prepared.indexType);
+    gpu.ranges = prepared.ranges;
+    gpu.lods = prepared.lods;
+    gpu.meshlets = prepared.meshlets;
+    gpu.materials = prepared.materials;
+    gpu.materialLibrary = prepared.materialLibrary;
+    return gpu;
+}
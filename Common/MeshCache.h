@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+#include "Mesh.h"
+
+// Cache binário de malhas (.meshcache), gravado ao lado do .obj na primeira
+// carga. Guarda os vértices já codificados no VertexFormat pedido (com a
+// dequantização correspondente), os índices em 16 ou 32 bits, a caixa
+// envolvente e as faixas de material. As cargas seguintes mapeiam o arquivo e
+// passam os ponteiros direto para glBufferData.
+//
+// Layout (little-endian): MeshCacheHeader | vértices | índices | faixas | LODs |
+// meshlets | nomes, com cada bloco alinhado em 16 bytes. Os nomes são strings
+// terminadas em zero: o mtllib do OBJ seguido de um nome por material. O bloco de vértices já vem
+// separado em fluxos, na mesma disposição do VBO (ver vertexBufferSize).
+
+const uint32_t MESH_CACHE_VERSION = 6;
+
+struct MeshCacheHeader
+{
+    char magic[4];          // "CGMC"
+    uint32_t version;       // MESH_CACHE_VERSION
+    uint64_t sourceSize;    // tamanho do .obj de origem
+    int64_t sourceTime;     // data de modificação do .obj de origem
+    uint64_t buildKey;      // hash das opções usadas para gerar a malha
+    uint32_t vertexStride;  // soma dos strides dos fluxos de vertexFormat
+    uint32_t vertexCount;
+    uint32_t indexSize;     // 2 ou 4 bytes
+    uint32_t indexCount;
+    uint32_t rangeCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t vertexFormat;  // packVertexFormat
+    float posScale[3];
+    float posOffset[3];
+    float uvScale[2];
+    float uvOffset[2];
+    uint32_t lodCount;      // níveis de detalhe (0 = só a malha original)
+    uint32_t meshletCount;
+    uint32_t materialCount;
+    uint32_t nameBytes;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t rangeOffset;
+    uint64_t lodOffset;
+    uint64_t meshletOffset;
+    uint64_t nameOffset;
+};
+
+// Identificação do arquivo de origem usada para invalidar o cache
+struct SourceStamp
+{
+    uint64_t size = 0;
+    int64_t time = 0;
+};
+
+// Cache aberto: os ponteiros apontam para dentro do arquivo mapeado
+struct MeshCacheView
+{
+    MappedFile file;
+    const MeshCacheHeader* header = nullptr;
+    const void* vertices = nullptr;
+    const void* indices = nullptr;
+    const MeshRange* ranges = nullptr;
+    const MeshLod* lods = nullptr;
+    const Meshlet* meshlets = nullptr;
+    std::string materialLibrary;
+    std::vector<std::string> materials;
+};
+
+bool readSourceStamp(const char* path, SourceStamp& stamp);
+
+// Caminho do cache de um .obj ("modelo.obj" -> "modelo.obj.meshcache")
+std::string meshCachePath(const char* sourcePath);
+
+// Hash FNV-1a de 64 bits, usado para compor a buildKey
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+// Abre o cache e confere versão, layout, buildKey, a assinatura da origem e se
+// faixas, LODs, meshlets e índices ficam dentro dos buffers (senão o cache é
+// refeito); só os nomes são copiados para fora do arquivo
+bool openMeshCache(const char* cachePath, const SourceStamp& stamp, uint64_t buildKey, MeshCacheView& view);
+
+// Nome temporário ao lado de `path`, único por processo, thread e chamada
+// ("<path>.<pid>-<thread>-<n>.tmp"), para que duas gravações do mesmo cache ao
+// mesmo tempo não escrevam no mesmo arquivo antes do rename
+std::string uniqueTempPath(const std::string& path);
+
+// Grava em um arquivo temporário e renomeia, para nunca deixar um cache parcial
+bool writeMeshCache(const char* cachePath, const SourceStamp& stamp, uint64_t buildKey, const IndexedMesh& mesh,
+                    const VertexFormat& format, const void* vertices, const Dequantization& dequant);
+
+// Malha pronta no lado da CPU, antes do envio. `vertices` e `indices` já estão
+// no formato final da GPU e apontam para dentro do cache mapeado ou para os
+// vetores `encoded`/`indices16`/`mesh.indices`.
+struct PreparedMesh
+{
+    MeshCacheView cache; // header != nullptr quando veio do cache
+    IndexedMesh mesh;
+    std::vector<uint8_t> encoded;
+    std::vector<uint16_t> indices16;
+
+    const void* vertices = nullptr;
+    size_t vertexCount = 0;
+    size_t vertexBytes = 0;
+    const void* indices = nullptr;
+    size_t indexCount = 0;
+    size_t indexBytes = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    VertexFormat format;
+    Dequantization dequant;
+    std::vector<MeshRange> ranges;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    std::vector<std::string> materials;
+    std::string materialLibrary; // caminho do .mtl a partir do diretório atual
+};
+
+// Caminho de um .mtl já resolvido a partir do diretório do .obj
+using MaterialLibraryHook = std::function<void(const std::string& mtlPath)>;
+
+// Carrega o .obj pelo cache quando ele é válido; senão lê o OBJ, monta e
+// otimiza a malha indexada, divide em meshlets, gera a cadeia de LOD e grava o
+// cache. Não usa OpenGL; pode rodar em qualquer thread. `onMaterialLibrary`
+// recebe cada mtllib assim que ele é conhecido (logo ao abrir o cache ou na
+// contagem do OBJ), antes de a malha ficar pronta.
+bool prepareMesh(const char* objPath, const VertexFormat& format, PreparedMesh& out,
+                 const MaterialLibraryHook& onMaterialLibrary = nullptr);
+
+// Envia para a GPU; precisa do contexto GL
+GpuMesh uploadPreparedMesh(const PreparedMesh& prepared);
@@ -0,0 +1,416 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+// Triângulos adjacentes a cada vértice em formato compacto (CSR)
+struct VertexAdjacency
+{
+    vector<uint32_t> offsets; // vertexCount + 1
+    vector<uint32_t> triangles;
+};
+
+void buildAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount, VertexAdjacency& adj)
+{
+    adj.offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; i++)
+        adj.offsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        adj.offsets[v + 1] += adj.offsets[v];
+
+    vector<uint32_t> cursor(adj.offsets.begin(), adj.offsets.end() - 1);
+    adj.triangles.resize(indexCount);
+    for (size_t i = 0; i < indexCount; i++)
+        adj.triangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+}
+
+// Resolução de cada vista da rasterização usada para medir overdraw
+const int OVERDRAW_GRID = 256;
+
+// Cache FIFO simulado, reiniciável, usado para achar os limites dos grupos
+struct FifoCache
+{
+    vector<size_t> insertedAt;
+    size_t time;
+    unsigned size;
+
+    FifoCache(size_t vertexCount, unsigned cacheSize)
+        : insertedAt(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+    unsigned access(uint32_t v)
+    {
+        if (time - insertedAt[v] > size) {
+            insertedAt[v] = time++;
+            return 1;
+        }
+        return 0;
+    }
+
+    unsigned triangle(const uint32_t* t)
+    {
+        return access(t[0]) + access(t[1]) + access(t[2]);
+    }
+
+    // Esvazia o cache sem percorrer os vértices
+    void reset() { time += size + 1; }
+};
+
+// Rasteriza um triângulo já em coordenadas de pixel (x, y) e profundidade (z).
+// Só triângulos com área de sinal `facing` (voltados para a câmera) são desenhados.
+void rasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float facing,
+                       vector<float>& depth, size_t& shaded)
+{
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area * facing <= 0.0f)
+        return;
+
+    int minX = max(0, (int)floor(min(a.x, min(b.x, c.x))));
+    int maxX = min(OVERDRAW_GRID - 1, (int)ceil(max(a.x, max(b.x, c.x))));
+    int minY = max(0, (int)floor(min(a.y, min(b.y, c.y))));
+    int maxY = min(OVERDRAW_GRID - 1, (int)ceil(max(a.y, max(b.y, c.y))));
+
+    float invArea = 1.0f / area;
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            float px = x + 0.5f, py = y + 0.5f;
+            float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * invArea;
+            float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * invArea;
+            float w2 = 1.0f - w0 - w1;
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                continue;
+
+            float z = w0 * a.z + w1 * b.z + w2 * c.z;
+            float& stored = depth[y * OVERDRAW_GRID + x];
+            if (z < stored) {
+                stored = z;
+                ++shaded;
+            }
+        }
+    }
+}
+
+void printStats(const char* name, const VertexCacheStats& before, const VertexCacheStats& after)
+{
+    cout << "Cache de vértices" << (name ? string(" (") + name + ")" : string()) << ": ACMR "
+         << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << endl;
+}
+
+void printStats(const char* name, const OverdrawStats& before, const OverdrawStats& after)
+{
+    cout << "Overdraw" << (name ? string(" (") + name + ")" : string()) << ": "
+         << before.overdraw << " -> " << after.overdraw << endl;
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount == 0)
+        return stats;
+
+    // FIFO exato: um vértice está no cache se entrou há menos de cacheSize misses
+    vector<size_t> insertedAt(vertexCount, 0);
+    vector<char> used(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    size_t unique = 0;
+
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t v = indices[i];
+        if (!used[v]) {
+            used[v] = 1;
+            ++unique;
+        }
+        if (time - insertedAt[v] > cacheSize) {
+            insertedAt[v] = time++;
+            ++stats.misses;
+        }
+    }
+
+    stats.acmr = (float)stats.misses / (float)(indexCount / 3);
+    stats.atvr = (float)stats.misses / (float)unique;
+    return stats;
+}
+
+OverdrawStats analyzeOverdraw(const vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount)
+{
+    OverdrawStats stats;
+    if (vertices.empty() || indexCount == 0)
+        return stats;
+
+    glm::vec3 boundsMin = vertices[0].position, boundsMax = vertices[0].position;
+    for (const MeshVertex& v : vertices) {
+        boundsMin = glm::min(boundsMin, v.position);
+        boundsMax = glm::max(boundsMax, v.position);
+    }
+    glm::vec3 extent = boundsMax - boundsMin;
+    float scale = max(extent.x, max(extent.y, extent.z));
+    scale = scale > 0.0f ? (OVERDRAW_GRID - 1) / scale : 1.0f;
+
+    vector<float> depth(OVERDRAW_GRID * OVERDRAW_GRID);
+
+    // Projeção ortográfica ao longo de +X, -X, +Y, -Y, +Z e -Z, com descarte de
+    // faces traseiras como em uma malha opaca fechada
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            fill(depth.begin(), depth.end(), numeric_limits<float>::max());
+
+            auto project = [&](uint32_t index) {
+                glm::vec3 p = (vertices[index].position - boundsMin) * scale;
+                float z = side ? p[axis] : -p[axis];
+                return glm::vec3(p[(axis + 1) % 3], p[(axis + 2) % 3], z);
+            };
+
+            // (x, y, eixo) é destro, então a área 2D tem o sinal da normal no
+            // eixo; a câmera do lado positivo (side = 0) vê as áreas positivas
+            float facing = side ? -1.0f : 1.0f;
+            for (size_t i = 0; i + 2 < indexCount; i += 3)
+                rasterizeTriangle(project(indices[i]), project(indices[i + 1]), project(indices[i + 2]),
+                                  facing, depth, stats.shaded);
+
+            for (float d : depth)
+                if (d != numeric_limits<float>::max())
+                    ++stats.covered;
+        }
+    }
+
+    stats.overdraw = stats.covered ? (float)stats.shaded / (float)stats.covered : 0.0f;
+    return stats;
+}
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    VertexAdjacency adj;
+    buildAdjacency(indices, indexCount, vertexCount, adj);
+
+    // Triângulos ainda não emitidos que usam cada vértice
+    vector<uint32_t> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        live[v] = adj.offsets[v + 1] - adj.offsets[v];
+
+    vector<size_t> cacheTime(vertexCount, 0);
+    vector<char> emitted(triangleCount, 0);
+    vector<uint32_t> deadEnd;
+    vector<uint32_t> candidates;
+    vector<uint32_t> output;
+    output.reserve(indexCount);
+
+    size_t timestamp = cacheSize + 1;
+    size_t cursor = 0;
+    long fan = 0;
+
+    while (fan >= 0) {
+        candidates.clear();
+
+        // Emite todos os triângulos pendentes em volta do vértice atual
+        for (uint32_t a = adj.offsets[fan]; a < adj.offsets[fan + 1]; a++) {
+            uint32_t t = adj.triangles[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = 1;
+
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (timestamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timestamp++;
+            }
+        }
+
+        // Próximo leque: o candidato que ainda estará no cache após emitir
+        // seus triângulos restantes, preferindo o que entrou há mais tempo
+        long best = -1;
+        long bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0)
+                continue;
+            long priority = 0;
+            if (timestamp - cacheTime[v] + 2 * live[v] <= cacheSize)
+                priority = (long)(timestamp - cacheTime[v]);
+            if (priority > bestPriority) {
+                best = v;
+                bestPriority = priority;
+            }
+        }
+
+        if (best < 0) {
+            // Beco sem saída: volta aos vértices emitidos recentemente e, por
+            // fim, procura o próximo vértice com triângulos pendentes
+            while (!deadEnd.empty()) {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0) {
+                    best = v;
+                    break;
+                }
+            }
+            while (best < 0 && cursor < vertexCount) {
+                if (live[cursor] > 0)
+                    best = (long)cursor;
+                ++cursor;
+            }
+        }
+        fan = best;
+    }
+
+    copy(output.begin(), output.end(), indices);
+}
+
+glm::vec3 indexedCenter(const vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount)
+{
+    glm::vec3 center(0.0f);
+    for (size_t i = 0; i < indexCount; i++)
+        center += vertices[indices[i]].position;
+    return indexCount ? center / (float)indexCount : center;
+}
+
+float overdrawSortKey(const vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount,
+                      const glm::vec3& center)
+{
+    glm::vec3 centroid(0.0f), normal(0.0f);
+    float area = 0.0f;
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        const glm::vec3& a = vertices[indices[i + 0]].position;
+        const glm::vec3& b = vertices[indices[i + 1]].position;
+        const glm::vec3& d = vertices[indices[i + 2]].position;
+        glm::vec3 n = glm::cross(b - a, d - a);
+        float triArea = glm::length(n);
+        centroid += (a + b + d) * (triArea / 3.0f);
+        normal += n;
+        area += triArea;
+    }
+    centroid = area > 0.0f ? centroid / area : vertices[indices[0]].position;
+    float len = glm::length(normal);
+    normal = len > 0.0f ? normal / len : glm::vec3(0.0f);
+    return glm::dot(centroid - center, normal);
+}
+
+void optimizeOverdraw(const vector<MeshVertex>& vertices, uint32_t* indices, size_t indexCount,
+                      float threshold, unsigned cacheSize)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || threshold <= 1.0f)
+        return;
+
+    // Limites rígidos: triângulos com 3 misses, onde o cache já foi esvaziado
+    vector<size_t> hard;
+    FifoCache cache(vertices.size(), cacheSize);
+    for (size_t t = 0; t < triangleCount; t++)
+        if (cache.triangle(indices + t * 3) == 3 || t == 0)
+            hard.push_back(t);
+    hard.push_back(triangleCount);
+
+    // Limites suaves: dentro de cada grupo rígido, fecha um grupo assim que o
+    // ACMR acumulado (com cache frio) fica abaixo do limite do grupo
+    vector<size_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); h++) {
+        size_t start = hard[h], end = hard[h + 1];
+
+        cache.reset();
+        size_t misses = 0;
+        for (size_t t = start; t < end; t++)
+            misses += cache.triangle(indices + t * 3);
+        float limit = threshold * (float)misses / (float)(end - start);
+
+        cache.reset();
+        size_t runningMisses = 0, runningTris = 0;
+        clusters.push_back(start);
+        for (size_t t = start; t < end; t++) {
+            runningMisses += cache.triangle(indices + t * 3);
+            runningTris++;
+            if ((float)runningMisses / (float)runningTris <= limit && t + 1 < end) {
+                clusters.push_back(t + 1);
+                cache.reset();
+                runningMisses = 0;
+                runningTris = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+    size_t clusterCount = clusters.size() - 1;
+
+    // Os grupos mais externos e voltados para fora vão primeiro
+    glm::vec3 center = indexedCenter(vertices, indices, indexCount);
+    vector<float> key(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        key[c] = overdrawSortKey(vertices, indices + clusters[c] * 3, (clusters[c + 1] - clusters[c]) * 3, center);
+
+    vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = (uint32_t)c;
+    stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+    vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (uint32_t c : order)
+        output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    copy(output.begin(), output.end(), indices);
+}
+
+void optimizeVertexFetch(IndexedMesh& mesh)
+{
+    const uint32_t UNUSED = ~0u;
+    vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+    vector<MeshVertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = (uint32_t)vertices.size();
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    mesh.vertices.swap(vertices);
+}
+
+MeshOrderStats analyzeMeshOrder(const IndexedMesh& mesh)
+{
+    MeshOrderStats stats;
+    stats.cache = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    stats.overdraw = analyzeOverdraw(mesh.vertices, mesh.indices.data(), mesh.indices.size());
+    return stats;
+}
+
+void printMeshOrderStats(const char* name, const MeshOrderStats& before, const MeshOrderStats& after)
+{
+    printStats(name, before.cache, after.cache);
+    printStats(name, before.overdraw, after.overdraw);
+}
+
+void reorderMesh(IndexedMesh& mesh, float overdrawThreshold)
+{
+    // Cada faixa continua contígua para poder ser desenhada separadamente
+    auto optimizeRange = [&](uint32_t* indices, size_t count) {
+        optimizeVertexCache(indices, count, mesh.vertices.size());
+        optimizeOverdraw(mesh.vertices, indices, count, overdrawThreshold);
+    };
+    if (mesh.ranges.empty()) {
+        optimizeRange(mesh.indices.data(), mesh.indices.size());
+    }
+    else {
+        for (const MeshRange& range : mesh.ranges)
+            optimizeRange(mesh.indices.data() + range.firstIndex, range.indexCount);
+    }
+    optimizeVertexFetch(mesh);
+}
+
+void optimizeMesh(IndexedMesh& mesh, const char* name, float overdrawThreshold)
+{
+    MeshOrderStats before = analyzeMeshOrder(mesh);
+    reorderMesh(mesh, overdrawThreshold);
+    printMeshOrderStats(name, before, analyzeMeshOrder(mesh));
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Mesh.h"
+
+// Tamanho do cache pós-transformação simulado (FIFO), próximo ao das GPUs atuais
+const unsigned VERTEX_CACHE_SIZE = 16;
+
+// Piora máxima aceita no ACMR de cada grupo ao reordenar contra overdraw
+// (1.05 = até 5% mais misses); valores <= 1 desativam a etapa
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+// Estatísticas do cache de vértices para uma ordem de triângulos
+struct VertexCacheStats
+{
+    size_t misses = 0;
+    float acmr = 0.0f; // misses por triângulo (ideal ~0.5, pior caso 3.0)
+    float atvr = 0.0f; // misses por vértice único (ideal 1.0)
+};
+
+// Simula um cache FIFO de `cacheSize` vértices sobre a lista de triângulos
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Overdraw medido rasterizando a malha em software nas 6 direções dos eixos,
+// descartando faces traseiras
+struct OverdrawStats
+{
+    size_t covered = 0; // pixels cobertos pela malha
+    size_t shaded = 0;  // fragmentos que passaram no teste de profundidade
+    float overdraw = 0.0f; // shaded / covered (ideal 1.0)
+};
+
+OverdrawStats analyzeOverdraw(const std::vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount);
+
+// Reordena os triângulos (Tipsify, Sander et al. 2007) para aproveitar o cache
+// pós-transformação. A orientação de cada triângulo é mantida.
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount,
+                         unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Reordenação independente de câmera contra overdraw (Sander et al. 2007). A
+// lista, já otimizada para o cache, é dividida em grupos cujo ACMR fica dentro
+// de `threshold` vezes o original; os grupos mais externos e voltados para fora
+// são desenhados primeiro, ocultando os demais pelo teste de profundidade.
+void optimizeOverdraw(const std::vector<MeshVertex>& vertices, uint32_t* indices, size_t indexCount,
+                      float threshold = OVERDRAW_THRESHOLD, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Média das posições referenciadas por `indices` (cada referência conta)
+glm::vec3 indexedCenter(const std::vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount);
+
+// Chave da ordem contra overdraw de um grupo de triângulos: quanto o grupo está
+// "para fora" de `center` na direção em que aponta. Grupos de chave maior são
+// desenhados primeiro (optimizeOverdraw, buildMeshlets).
+float overdrawSortKey(const std::vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount,
+                      const glm::vec3& center);
+
+// Renumera os vértices na ordem do primeiro uso pelos índices, para que a
+// leitura do VBO seja sequencial. Vértices não referenciados são descartados.
+void optimizeVertexFetch(IndexedMesh& mesh);
+
+// ACMR/ATVR e overdraw da ordem atual dos triângulos da malha inteira
+struct MeshOrderStats
+{
+    VertexCacheStats cache;
+    OverdrawStats overdraw;
+};
+
+MeshOrderStats analyzeMeshOrder(const IndexedMesh& mesh);
+void printMeshOrderStats(const char* name, const MeshOrderStats& before, const MeshOrderStats& after);
+
+// Aplica as etapas acima (cache, overdraw e leitura de vértices) em cada faixa
+// da malha, sem imprimir nada
+void reorderMesh(IndexedMesh& mesh, float overdrawThreshold = OVERDRAW_THRESHOLD);
+
+// reorderMesh imprimindo ACMR/ATVR e overdraw antes e depois. Usada em malhas
+// procedurais no momento da carga; na geração do cache os meshlets reordenam
+// os triângulos depois, e as estatísticas saem só no fim (prepareMesh).
+void optimizeMesh(IndexedMesh& mesh, const char* name = nullptr, float overdrawThreshold = OVERDRAW_THRESHOLD);
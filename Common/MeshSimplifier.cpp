@@ -0,0 +1,563 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+// Peso das quádricas extras de bordas e costuras em relação às das faces
+const double BOUNDARY_WEIGHT = 10.0;
+
+// Níveis que não reduzem pelo menos 10% dos triângulos encerram a cadeia
+const float LOD_MIN_REDUCTION = 0.9f;
+
+// Soma ponderada de quádricas de planos: erro(p) = p'Ap + 2b'p + c
+struct Quadric
+{
+    double a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+    double weight = 0;
+};
+
+void addPlane(Quadric& q, const glm::vec3& n, float d, double weight)
+{
+    q.a00 += weight * n.x * n.x;
+    q.a11 += weight * n.y * n.y;
+    q.a22 += weight * n.z * n.z;
+    q.a10 += weight * n.y * n.x;
+    q.a20 += weight * n.z * n.x;
+    q.a21 += weight * n.z * n.y;
+    q.b0 += weight * n.x * d;
+    q.b1 += weight * n.y * d;
+    q.b2 += weight * n.z * d;
+    q.c += weight * d * d;
+    q.weight += weight;
+}
+
+void addQuadric(Quadric& q, const Quadric& r)
+{
+    q.a00 += r.a00;
+    q.a11 += r.a11;
+    q.a22 += r.a22;
+    q.a10 += r.a10;
+    q.a20 += r.a20;
+    q.a21 += r.a21;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+    q.weight += r.weight;
+}
+
+// Média ponderada do quadrado da distância de `p` aos planos acumulados
+double quadricError(const Quadric& q, const glm::vec3& p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double r = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+               2.0 * (q.a10 * x * y + q.a20 * x * z + q.a21 * y * z) +
+               2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    return q.weight > 0.0 ? max(r, 0.0) / q.weight : 0.0;
+}
+
+// Como cada posição pode colapsar
+enum VertexKind : uint8_t
+{
+    KIND_MANIFOLD, // interior, um único vértice na posição: colapsa para qualquer vizinho
+    KIND_BORDER,   // em uma borda aberta: só ao longo da borda
+    KIND_SEAM,     // dois vértices na posição (costura de normal/UV): só ao longo da costura
+    KIND_LOCKED    // qualquer outro caso: não colapsa, mas pode receber colapsos
+};
+
+// Semiaresta entre duas posições e os vértices que a formam
+struct HalfEdge
+{
+    uint32_t from;
+    uint32_t to;
+    uint32_t count;
+};
+
+inline uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+    return ((uint64_t)a << 32) | b;
+}
+
+struct Collapse
+{
+    uint32_t from; // posição que desaparece
+    uint32_t to;   // posição que recebe os triângulos
+    double cost;
+};
+
+// Estado da simplificação: vértices agrupados por posição e quádricas por posição
+struct Simplifier
+{
+    const vector<MeshVertex>& vertices;
+    vector<uint32_t> point;  // vértice -> representante da sua posição
+    vector<uint32_t> wedge;  // anel dos vértices referenciados na mesma posição
+    vector<uint8_t> kind;    // por representante
+    vector<Quadric> quadrics;
+    unordered_map<uint64_t, HalfEdge> edges;
+
+    explicit Simplifier(const vector<MeshVertex>& v) : vertices(v) {}
+
+    const glm::vec3& position(uint32_t p) const { return vertices[p].position; }
+
+    const HalfEdge* findEdge(uint32_t a, uint32_t b) const
+    {
+        auto it = edges.find(edgeKey(a, b));
+        return it == edges.end() ? nullptr : &it->second;
+    }
+
+    // Semiarestas atuais por posição
+    void buildEdges(const vector<uint32_t>& tris)
+    {
+        edges.clear();
+        edges.reserve(tris.size());
+        for (size_t i = 0; i < tris.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = tris[i + k], b = tris[i + (k + 1) % 3];
+                HalfEdge& he = edges[edgeKey(point[a], point[b])];
+                if (he.count++ == 0) {
+                    he.from = a;
+                    he.to = b;
+                }
+            }
+        }
+    }
+
+    // Borda: falta a semiaresta oposta. Costura: a oposta usa outros vértices.
+    bool isOpen(const HalfEdge& he) const
+    {
+        return !findEdge(point[he.to], point[he.from]);
+    }
+
+    bool isSeam(const HalfEdge& he) const
+    {
+        const HalfEdge* opposite = findEdge(point[he.to], point[he.from]);
+        return opposite && (opposite->from != he.to || opposite->to != he.from);
+    }
+};
+
+void groupPositions(Simplifier& s, const vector<uint32_t>& tris)
+{
+    size_t vertexCount = s.vertices.size();
+    vector<uint32_t> used;
+    vector<uint8_t> referenced(vertexCount, 0);
+    for (uint32_t v : tris)
+        if (!referenced[v]) {
+            referenced[v] = 1;
+            used.push_back(v);
+        }
+
+    // Ordena os vértices usados por posição; vértices iguais ficam vizinhos
+    sort(used.begin(), used.end(), [&](uint32_t a, uint32_t b) {
+        const glm::vec3& pa = s.vertices[a].position;
+        const glm::vec3& pb = s.vertices[b].position;
+        if (pa.x != pb.x)
+            return pa.x < pb.x;
+        if (pa.y != pb.y)
+            return pa.y < pb.y;
+        if (pa.z != pb.z)
+            return pa.z < pb.z;
+        return a < b;
+    });
+
+    s.point.resize(vertexCount);
+    s.wedge.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        s.point[v] = s.wedge[v] = (uint32_t)v;
+
+    for (size_t i = 0; i < used.size();) {
+        size_t j = i + 1;
+        while (j < used.size() && s.vertices[used[j]].position == s.vertices[used[i]].position)
+            ++j;
+        for (size_t k = i; k < j; k++) {
+            s.point[used[k]] = used[i];
+            s.wedge[used[k]] = used[k + 1 < j ? k + 1 : i];
+        }
+        i = j;
+    }
+}
+
+void classifyVertices(Simplifier& s, const unsigned char* locked)
+{
+    size_t vertexCount = s.vertices.size();
+    vector<uint8_t> openEdges(vertexCount, 0), seamEdges(vertexCount, 0), complex(vertexCount, 0);
+
+    auto bump = [](uint8_t& counter) {
+        if (counter < 255)
+            ++counter;
+    };
+
+    for (const auto& entry : s.edges) {
+        const HalfEdge& he = entry.second;
+        uint32_t a = s.point[he.from], b = s.point[he.to];
+        if (he.count > 1) {
+            // Aresta não variedade (mais de duas faces ou orientação inconsistente)
+            complex[a] = complex[b] = 1;
+        }
+        else if (s.isOpen(he)) {
+            bump(openEdges[a]);
+            bump(openEdges[b]);
+        }
+        else if (s.isSeam(he)) {
+            bump(seamEdges[a]);
+        }
+    }
+
+    s.kind.assign(vertexCount, KIND_LOCKED);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (s.point[v] != v || complex[v])
+            continue;
+
+        int wedges = 1;
+        bool lockedWedge = locked && locked[v];
+        for (uint32_t w = s.wedge[v]; w != v; w = s.wedge[w]) {
+            ++wedges;
+            lockedWedge = lockedWedge || (locked && locked[w]);
+        }
+        if (lockedWedge)
+            continue;
+
+        if (wedges == 1 && openEdges[v] == 0 && seamEdges[v] == 0)
+            s.kind[v] = KIND_MANIFOLD;
+        else if (wedges == 1 && openEdges[v] == 2 && seamEdges[v] == 0)
+            s.kind[v] = KIND_BORDER;
+        else if (wedges == 2 && openEdges[v] == 0 && seamEdges[v] == 2)
+            s.kind[v] = KIND_SEAM;
+    }
+}
+
+void fillQuadrics(Simplifier& s, const vector<uint32_t>& tris)
+{
+    s.quadrics.assign(s.vertices.size(), Quadric());
+
+    for (size_t i = 0; i < tris.size(); i += 3) {
+        uint32_t p[3] = { s.point[tris[i]], s.point[tris[i + 1]], s.point[tris[i + 2]] };
+        glm::vec3 n = glm::cross(s.position(p[1]) - s.position(p[0]), s.position(p[2]) - s.position(p[0]));
+        float length = glm::length(n);
+        if (length == 0.0f)
+            continue;
+        n /= length;
+
+        // Plano da face, com peso proporcional à área
+        float d = -glm::dot(n, s.position(p[0]));
+        for (int k = 0; k < 3; k++)
+            addPlane(s.quadrics[p[k]], n, d, length * 0.5);
+
+        // Plano perpendicular à face passando pelas arestas de borda e de
+        // costura, para que elas não encolham nem se desloquem
+        for (int k = 0; k < 3; k++) {
+            const HalfEdge* he = s.findEdge(p[k], p[(k + 1) % 3]);
+            if (!he || (!s.isOpen(*he) && !s.isSeam(*he)))
+                continue;
+
+            glm::vec3 edge = s.position(p[(k + 1) % 3]) - s.position(p[k]);
+            glm::vec3 side = glm::cross(edge, n);
+            float sideLength = glm::length(side);
+            if (sideLength == 0.0f)
+                continue;
+            side /= sideLength;
+
+            double weight = glm::dot(edge, edge) * BOUNDARY_WEIGHT;
+            float sideD = -glm::dot(side, s.position(p[k]));
+            addPlane(s.quadrics[p[k]], side, sideD, weight);
+            addPlane(s.quadrics[p[(k + 1) % 3]], side, sideD, weight);
+        }
+    }
+}
+
+bool canCollapse(const Simplifier& s, const HalfEdge& he, uint32_t from, uint32_t to)
+{
+    switch (s.kind[from]) {
+        case KIND_MANIFOLD:
+            return true;
+        case KIND_BORDER:
+            return (s.kind[to] == KIND_BORDER || s.kind[to] == KIND_LOCKED) && s.isOpen(he);
+        case KIND_SEAM:
+            return (s.kind[to] == KIND_SEAM || s.kind[to] == KIND_LOCKED) && s.isSeam(he);
+        default:
+            return false;
+    }
+}
+
+// Mover `from` para a posição de `to` não pode inverter nenhum triângulo em volta
+bool flipsTriangles(const Simplifier& s, const vector<uint32_t>& tris, const vector<uint32_t>& offsets,
+                    const vector<uint32_t>& adjacency, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = offsets[from]; i < offsets[from + 1]; i++) {
+        const uint32_t* t = &tris[adjacency[i] * 3];
+        uint32_t p[3] = { s.point[t[0]], s.point[t[1]], s.point[t[2]] };
+        if (p[0] == to || p[1] == to || p[2] == to)
+            continue;
+
+        glm::vec3 before[3], after[3];
+        for (int k = 0; k < 3; k++) {
+            before[k] = s.position(p[k]);
+            after[k] = p[k] == from ? s.position(to) : before[k];
+        }
+        glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+        glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+        if (glm::dot(n0, n1) <= 0.0f)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+size_t simplifyMesh(const vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount,
+                    size_t targetIndexCount, float targetError, uint32_t* destination, float* resultError,
+                    const unsigned char* locked)
+{
+    Simplifier s(vertices);
+    size_t vertexCount = vertices.size();
+
+    vector<uint32_t> tris(indices, indices + indexCount);
+    groupPositions(s, tris);
+
+    // Descarta triângulos já degenerados (dois cantos na mesma posição)
+    size_t kept = 0;
+    for (size_t i = 0; i < tris.size(); i += 3) {
+        uint32_t a = s.point[tris[i]], b = s.point[tris[i + 1]], c = s.point[tris[i + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        for (int k = 0; k < 3; k++)
+            tris[kept + k] = tris[i + k];
+        kept += 3;
+    }
+    tris.resize(kept);
+
+    s.buildEdges(tris);
+    classifyVertices(s, locked);
+    fillQuadrics(s, tris);
+
+    double errorLimit = (double)targetError * targetError;
+    double worstError = 0.0;
+
+    vector<uint32_t> offsets, adjacency, remap(vertexCount);
+    vector<uint8_t> passLocked(vertexCount);
+    vector<Collapse> candidates;
+
+    while (tris.size() > targetIndexCount) {
+        // Triângulos em volta de cada posição (CSR)
+        offsets.assign(vertexCount + 1, 0);
+        for (uint32_t v : tris)
+            offsets[s.point[v] + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        adjacency.resize(tris.size());
+        vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < tris.size(); i++)
+            adjacency[cursor[s.point[tris[i]]]++] = (uint32_t)(i / 3);
+
+        // Melhor sentido de colapso de cada aresta
+        candidates.clear();
+        for (const auto& entry : s.edges) {
+            const HalfEdge& he = entry.second;
+            uint32_t a = s.point[he.from], b = s.point[he.to];
+            if (a > b && !s.isOpen(he))
+                continue; // a semiaresta oposta avalia a mesma aresta
+
+            Collapse best = { 0, 0, -1.0 };
+            if (canCollapse(s, he, a, b))
+                best = { a, b, quadricError(s.quadrics[a], s.position(b)) };
+            if (canCollapse(s, he, b, a)) {
+                double cost = quadricError(s.quadrics[b], s.position(a));
+                if (best.cost < 0.0 || cost < best.cost)
+                    best = { b, a, cost };
+            }
+            if (best.cost >= 0.0 && best.cost <= errorLimit)
+                candidates.push_back(best);
+        }
+        if (candidates.empty())
+            break;
+
+        sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) {
+            return x.cost < y.cost;
+        });
+
+        for (size_t v = 0; v < vertexCount; v++)
+            remap[v] = (uint32_t)v;
+        fill(passLocked.begin(), passLocked.end(), 0);
+
+        size_t triangles = tris.size() / 3;
+        size_t targetTriangles = targetIndexCount / 3;
+        size_t collapses = 0;
+
+        for (const Collapse& c : candidates) {
+            if (triangles <= targetTriangles)
+                break;
+            if (passLocked[c.from] || passLocked[c.to])
+                continue;
+            if (flipsTriangles(s, tris, offsets, adjacency, c.from, c.to))
+                continue;
+
+            // Cada vértice da posição que some é trocado pelo vértice do mesmo
+            // lado da aresta na posição de destino
+            const HalfEdge* forward = s.findEdge(c.from, c.to);
+            const HalfEdge* backward = s.findEdge(c.to, c.from);
+            if (s.kind[c.from] == KIND_SEAM) {
+                if (!forward || !backward || backward->to == forward->from || backward->to != s.wedge[forward->from])
+                    continue;
+                remap[forward->from] = forward->to;
+                remap[backward->to] = backward->from;
+            }
+            else {
+                uint32_t target = forward ? forward->to : backward->from;
+                remap[c.from] = target;
+            }
+
+            addQuadric(s.quadrics[c.to], s.quadrics[c.from]);
+            worstError = max(worstError, c.cost);
+
+            // A vizinhança de `from` muda; nada nela colapsa de novo nesta passada
+            for (uint32_t i = offsets[c.from]; i < offsets[c.from + 1]; i++) {
+                const uint32_t* t = &tris[adjacency[i] * 3];
+                for (int k = 0; k < 3; k++)
+                    passLocked[s.point[t[k]]] = 1;
+            }
+
+            triangles -= s.kind[c.from] == KIND_BORDER ? 1 : 2;
+            ++collapses;
+        }
+
+        if (collapses == 0)
+            break;
+
+        // Aplica os colapsos e remove os triângulos que degeneraram
+        kept = 0;
+        for (size_t i = 0; i < tris.size(); i += 3) {
+            uint32_t a = remap[tris[i]], b = remap[tris[i + 1]], c = remap[tris[i + 2]];
+            if (s.point[a] == s.point[b] || s.point[b] == s.point[c] || s.point[a] == s.point[c])
+                continue;
+            tris[kept] = a;
+            tris[kept + 1] = b;
+            tris[kept + 2] = c;
+            kept += 3;
+        }
+        tris.resize(kept);
+        s.buildEdges(tris);
+    }
+
+    copy(tris.begin(), tris.end(), destination);
+    if (resultError)
+        *resultError = (float)sqrt(worstError);
+    return tris.size();
+}
+
+void buildLodChain(IndexedMesh& mesh, const char* name, int maxLevels, float maxError)
+{
+    // Recomeça a partir do nível 0 caso a malha já tenha uma cadeia
+    if (!mesh.lods.empty()) {
+        mesh.indices.resize(mesh.lods[0].indexCount);
+        mesh.ranges.resize(mesh.lods[0].rangeCount);
+        mesh.lods.clear();
+    }
+    if (mesh.ranges.empty())
+        mesh.ranges.assign(1, MeshRange{ 0, (uint32_t)mesh.indices.size(), -1, -1, mesh.boundsMin, mesh.boundsMax });
+
+    mesh.lods.push_back(MeshLod{ 0, (uint32_t)mesh.indices.size(), 0, (uint32_t)mesh.ranges.size(), 0.0f });
+
+    // Posições usadas por mais de uma faixa ficam travadas, para que faixas
+    // simplificadas separadamente não abram frestas entre si
+    vector<unsigned char> locked;
+    if (mesh.ranges.size() > 1) {
+        vector<int> owner(mesh.vertices.size(), -1);
+        locked.assign(mesh.vertices.size(), 0);
+        for (size_t r = 0; r < mesh.ranges.size(); r++) {
+            const MeshRange& range = mesh.ranges[r];
+            for (uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; i++) {
+                uint32_t v = mesh.indices[i];
+                if (owner[v] >= 0 && owner[v] != (int)r)
+                    locked[v] = 1;
+                owner[v] = (int)r;
+            }
+        }
+
+        // Propaga a trava para vértices de outras faixas na mesma posição
+        vector<uint32_t> order(mesh.vertices.size());
+        for (size_t v = 0; v < order.size(); v++)
+            order[v] = (uint32_t)v;
+        sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            const glm::vec3& pa = mesh.vertices[a].position;
+            const glm::vec3& pb = mesh.vertices[b].position;
+            if (pa.x != pb.x)
+                return pa.x < pb.x;
+            if (pa.y != pb.y)
+                return pa.y < pb.y;
+            return pa.z < pb.z;
+        });
+        for (size_t i = 0; i < order.size();) {
+            size_t j = i + 1;
+            while (j < order.size() && mesh.vertices[order[j]].position == mesh.vertices[order[i]].position)
+                ++j;
+            bool mixed = false;
+            for (size_t k = i + 1; k < j; k++)
+                mixed = mixed || owner[order[k]] != owner[order[i]] || locked[order[k]] || locked[order[i]];
+            if (mixed)
+                for (size_t k = i; k < j; k++)
+                    locked[order[k]] = 1;
+            i = j;
+        }
+    }
+
+    float diagonal = glm::length(mesh.boundsMax - mesh.boundsMin);
+    float errorLimit = maxError * diagonal;
+    size_t originalTriangles = mesh.indices.size() / 3;
+
+    // Cada nível parte do nível 0, então o erro medido já é em relação à
+    // malha original; só o número de triângulos alvo cai pela metade
+    vector<uint32_t> source, simplified;
+    const MeshLod base = mesh.lods[0];
+    for (int level = 1; level < maxLevels; level++) {
+        const MeshLod previous = mesh.lods.back();
+        MeshLod lod = { (uint32_t)mesh.indices.size(), 0, (uint32_t)mesh.ranges.size(), 0, 0.0f };
+
+        for (uint32_t r = base.firstRange; r < base.firstRange + base.rangeCount; r++) {
+            MeshRange range = mesh.ranges[r];
+            source.assign(mesh.indices.begin() + range.firstIndex,
+                          mesh.indices.begin() + range.firstIndex + range.indexCount);
+            simplified.resize(source.size());
+
+            float rangeError = 0.0f;
+            size_t target = (size_t)range.indexCount * previous.indexCount / max<uint32_t>(base.indexCount, 1) / 6 * 3;
+            size_t count = simplifyMesh(mesh.vertices, source.data(), source.size(), target, errorLimit,
+                                        simplified.data(), &rangeError, locked.empty() ? nullptr : locked.data());
+            optimizeVertexCache(simplified.data(), count, mesh.vertices.size());
+            lod.error = max(lod.error, rangeError);
+
+            // Mesmo material, objeto e caixa da faixa de origem (a simplificada cabe nela)
+            range.firstIndex = (uint32_t)mesh.indices.size();
+            range.indexCount = (uint32_t)count;
+            mesh.ranges.push_back(range);
+            mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.begin() + count);
+            lod.indexCount += (uint32_t)count;
+            lod.rangeCount++;
+        }
+
+        if (lod.indexCount == 0 || lod.indexCount > previous.indexCount * LOD_MIN_REDUCTION) {
+            mesh.indices.resize(lod.firstIndex);
+            mesh.ranges.resize(lod.firstRange);
+            break;
+        }
+        mesh.lods.push_back(lod);
+    }
+
+    for (size_t level = 0; level < mesh.lods.size(); level++) {
+        const MeshLod& lod = mesh.lods[level];
+        size_t triangles = lod.indexCount / 3;
+        cout << "LOD " << level;
+        if (name)
+            cout << " (" << name << ")";
+        cout << ": " << triangles << " triângulos (" << 100.0 * triangles / max<size_t>(originalTriangles, 1)
+             << "%), erro " << lod.error << " (" << (diagonal > 0.0f ? 100.0f * lod.error / diagonal : 0.0f)
+             << "% da diagonal)" << endl;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Mesh.h"
+
+// Quantidade máxima de níveis da cadeia de LOD, contando a malha original
+const int MAX_LOD_LEVELS = 6;
+
+// Erro geométrico máximo aceito no nível mais simples, em fração da diagonal
+// da caixa envolvente da malha
+const float LOD_MAX_ERROR = 0.05f;
+
+// Simplifica a lista de triângulos por colapso de arestas guiado por quádricas
+// de erro (Garland e Heckbert 1997). Cada colapso move um vértice para um
+// vizinho já existente, então o resultado usa os mesmos vértices de entrada.
+//
+// Vértices na mesma posição com normal ou UV diferentes formam uma costura:
+// eles só colapsam ao longo da costura, todos juntos, e bordas abertas só
+// colapsam ao longo da borda; as duas recebem quádricas extras para não
+// encolher. Vértices em configurações mais complexas ficam travados.
+//
+// Para ao chegar em `targetIndexCount` ou quando o próximo colapso passaria de
+// `targetError` (distância, em unidades do objeto). Escreve em `destination`
+// (pelo menos indexCount entradas) e retorna quantos índices foram gerados;
+// `resultError` recebe o erro do pior colapso realizado. Vértices marcados em
+// `locked` (um byte por vértice, opcional) nunca saem do lugar.
+size_t simplifyMesh(const std::vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount,
+                    size_t targetIndexCount, float targetError, uint32_t* destination, float* resultError = nullptr,
+                    const unsigned char* locked = nullptr);
+
+// Gera até `maxLevels` níveis, cada um com cerca de metade dos triângulos do
+// anterior, simplificando a partir do nível 0 cada faixa de material
+// separadamente. Os índices e
+// faixas de cada nível são acrescentados à malha e descritos em `mesh.lods`;
+// o nível 0 é a malha original. Imprime triângulos e erro de cada nível.
+void buildLodChain(IndexedMesh& mesh, const char* name = nullptr, int maxLevels = MAX_LOD_LEVELS,
+                   float maxError = LOD_MAX_ERROR);
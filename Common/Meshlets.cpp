@@ -0,0 +1,417 @@
+#include "Meshlets.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+// Peso da diferença de normal em relação a cada vértice novo na escolha do
+// próximo triângulo do meshlet
+const float MESHLET_CONE_WEIGHT = 2.0f;
+
+// Cones com algum triângulo a mais de ~84 graus do eixo não descartam nada
+const float MESHLET_MIN_CONE_DOT = 0.1f;
+
+glm::vec3 triangleNormal(const vector<MeshVertex>& vertices, const uint32_t* t)
+{
+    glm::vec3 n = glm::cross(vertices[t[1]].position - vertices[t[0]].position,
+                             vertices[t[2]].position - vertices[t[0]].position);
+    float length = glm::length(n);
+    return length > 0.0f ? n / length : glm::vec3(0.0f);
+}
+
+// Reordena os triângulos do meshlet para o cache de vértices usando índices
+// locais (no máximo MESHLET_MAX_VERTICES), sem custo proporcional à malha toda
+void optimizeMeshletCache(uint32_t* indices, size_t indexCount)
+{
+    uint32_t local[MESHLET_MAX_TRIANGLES * 3];
+    uint32_t global[MESHLET_MAX_TRIANGLES * 3];
+    uint32_t unique = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t k = 0;
+        while (k < unique && global[k] != indices[i])
+            ++k;
+        if (k == unique)
+            global[unique++] = indices[i];
+        local[i] = k;
+    }
+
+    optimizeVertexCache(local, indexCount, unique);
+    for (size_t i = 0; i < indexCount; i++)
+        indices[i] = global[local[i]];
+}
+
+// Divide os triângulos de uma faixa, escrevendo-os de volta agrupados e com os
+// meshlets na ordem contra overdraw
+void partitionRange(const vector<MeshVertex>& vertices, uint32_t* indices, size_t indexCount,
+                    uint32_t firstIndex, vector<Meshlet>& meshlets)
+{
+    size_t triangleCount = indexCount / 3;
+    size_t vertexCount = vertices.size();
+
+    // Triângulos em volta de cada vértice (CSR)
+    vector<uint32_t> offsets(vertexCount + 1, 0), adjacency(indexCount);
+    for (size_t i = 0; i < indexCount; i++)
+        offsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] += offsets[v];
+    vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; i++)
+        adjacency[cursor[indices[i]]++] = (uint32_t)(i / 3);
+
+    vector<glm::vec3> normals(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        normals[t] = triangleNormal(vertices, &indices[t * 3]);
+
+    vector<uint8_t> emitted(triangleCount, 0);
+    vector<uint32_t> stamp(vertexCount, 0); // meshlet que já usa o vértice (+1)
+    vector<uint32_t> order, candidates;
+    order.reserve(indexCount);
+
+    size_t firstMeshlet = meshlets.size();
+    uint32_t meshletId = 0;
+    size_t seed = 0;
+    while (true) {
+        while (seed < triangleCount && emitted[seed])
+            ++seed;
+        if (seed == triangleCount)
+            break;
+
+        ++meshletId;
+        size_t meshletStart = order.size();
+        unsigned meshletVertices = 0, meshletTriangles = 0;
+        glm::vec3 normalSum(0.0f);
+        candidates.clear();
+
+        auto newVertices = [&](size_t t) {
+            unsigned count = 0;
+            for (int k = 0; k < 3; k++)
+                count += stamp[indices[t * 3 + k]] != meshletId;
+            return count;
+        };
+
+        auto add = [&](size_t t) {
+            emitted[t] = 1;
+            ++meshletTriangles;
+            normalSum += normals[t];
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                order.push_back(v);
+                if (stamp[v] != meshletId) {
+                    stamp[v] = meshletId;
+                    ++meshletVertices;
+                    for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+                        if (!emitted[adjacency[i]])
+                            candidates.push_back(adjacency[i]);
+                }
+            }
+        };
+
+        add(seed);
+
+        while (meshletTriangles < MESHLET_MAX_TRIANGLES) {
+            float normalLength = glm::length(normalSum);
+            glm::vec3 axis = normalLength > 0.0f ? normalSum / normalLength : glm::vec3(0.0f);
+
+            // Menos vértices novos primeiro; em seguida a normal mais próxima do cone
+            size_t best = triangleCount;
+            float bestScore = 0.0f;
+            size_t kept = 0;
+            for (size_t c = 0; c < candidates.size(); c++) {
+                uint32_t t = candidates[c];
+                if (emitted[t])
+                    continue;
+                candidates[kept++] = t;
+
+                unsigned extra = newVertices(t);
+                if (meshletVertices + extra > MESHLET_MAX_VERTICES)
+                    continue;
+                float score = extra + (1.0f - glm::dot(normals[t], axis)) * MESHLET_CONE_WEIGHT;
+                if (best == triangleCount || score < bestScore) {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+            candidates.resize(kept);
+
+            if (best == triangleCount)
+                break;
+            add(best);
+        }
+
+        optimizeMeshletCache(&order[meshletStart], order.size() - meshletStart);
+
+        Meshlet meshlet;
+        meshlet.firstIndex = firstIndex + (uint32_t)meshletStart;
+        meshlet.indexCount = (uint32_t)(order.size() - meshletStart);
+        computeMeshletBounds(vertices, &order[meshletStart], meshlet.indexCount, meshlet);
+        meshlets.push_back(meshlet);
+    }
+
+    // Meshlets na ordem contra overdraw (os mais externos e voltados para fora
+    // primeiro), como os grupos de optimizeOverdraw; dentro de cada um a ordem
+    // do Tipsify é mantida
+    glm::vec3 center = indexedCenter(vertices, order.data(), order.size());
+    size_t count = meshlets.size() - firstMeshlet;
+    vector<float> key(count);
+    vector<uint32_t> sorted(count);
+    for (size_t m = 0; m < count; m++) {
+        const Meshlet& meshlet = meshlets[firstMeshlet + m];
+        key[m] = overdrawSortKey(vertices, &order[meshlet.firstIndex - firstIndex], meshlet.indexCount, center);
+        sorted[m] = (uint32_t)m;
+    }
+    stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+    vector<Meshlet> placed;
+    placed.reserve(count);
+    uint32_t written = 0;
+    for (uint32_t m : sorted) {
+        Meshlet meshlet = meshlets[firstMeshlet + m];
+        copy(order.begin() + (meshlet.firstIndex - firstIndex),
+             order.begin() + (meshlet.firstIndex - firstIndex + meshlet.indexCount), indices + written);
+        meshlet.firstIndex = firstIndex + written;
+        written += meshlet.indexCount;
+        placed.push_back(meshlet);
+    }
+    copy(placed.begin(), placed.end(), meshlets.begin() + firstMeshlet);
+}
+
+// Planos do frustum (a, b, c, d normalizados) extraídos da matriz de projeção
+void extractFrustum(const glm::mat4& m, glm::vec4 planes[6])
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+    for (int i = 0; i < 6; i++) {
+        float length = glm::length(glm::vec3(planes[i]));
+        if (length > 0.0f)
+            planes[i] /= length;
+    }
+}
+
+// Caixa inteira atrás de algum plano: o vértice mais à frente dela já está fora
+bool boxOutside(const glm::vec4 planes[6], const glm::vec3& lo, const glm::vec3& hi)
+{
+    for (int i = 0; i < 6; i++) {
+        glm::vec3 n(planes[i]);
+        glm::vec3 farthest(n.x >= 0.0f ? hi.x : lo.x, n.y >= 0.0f ? hi.y : lo.y, n.z >= 0.0f ? hi.z : lo.z);
+        if (glm::dot(n, farthest) + planes[i].w < 0.0f)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void computeMeshletBounds(const vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount,
+                          Meshlet& meshlet)
+{
+    glm::vec3 lo = vertices[indices[0]].position, hi = lo;
+    for (size_t i = 1; i < indexCount; i++) {
+        lo = glm::min(lo, vertices[indices[i]].position);
+        hi = glm::max(hi, vertices[indices[i]].position);
+    }
+    meshlet.center = (lo + hi) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (size_t i = 0; i < indexCount; i++)
+        meshlet.radius = max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+
+    glm::vec3 normalSum(0.0f);
+    for (size_t i = 0; i < indexCount; i += 3)
+        normalSum += triangleNormal(vertices, &indices[i]);
+
+    meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneCutoff = 1.0f;
+
+    float normalLength = glm::length(normalSum);
+    if (normalLength == 0.0f)
+        return;
+    glm::vec3 axis = normalSum / normalLength;
+
+    float minDot = 1.0f;
+    for (size_t i = 0; i < indexCount; i += 3) {
+        glm::vec3 n = triangleNormal(vertices, &indices[i]);
+        if (n != glm::vec3(0.0f))
+            minDot = min(minDot, glm::dot(n, axis));
+    }
+    meshlet.coneAxis = axis;
+    if (minDot <= MESHLET_MIN_CONE_DOT)
+        return;
+
+    // Ápice do cone: recuado ao longo do eixo até ficar atrás de todos os
+    // planos dos triângulos, para que o teste valha de qualquer ponto de vista
+    float maxT = 0.0f;
+    for (size_t i = 0; i < indexCount; i += 3) {
+        glm::vec3 n = triangleNormal(vertices, &indices[i]);
+        float dn = glm::dot(axis, n);
+        if (dn <= 0.0f)
+            continue;
+        float t = glm::dot(meshlet.center - vertices[indices[i]].position, n) / dn;
+        maxT = max(maxT, t);
+    }
+    meshlet.coneApex = meshlet.center - axis * maxT;
+    meshlet.coneCutoff = sqrt(1.0f - minDot * minDot);
+}
+
+void buildMeshlets(IndexedMesh& mesh, const char* name)
+{
+    mesh.meshlets.clear();
+
+    // Só o nível 0 é dividido; os LODs acrescentados depois dele ficam como estão
+    uint32_t firstRange = 0;
+    uint32_t rangeCount = (uint32_t)mesh.ranges.size();
+    uint32_t levelIndices = (uint32_t)mesh.indices.size();
+    if (!mesh.lods.empty()) {
+        firstRange = mesh.lods[0].firstRange;
+        rangeCount = mesh.lods[0].rangeCount;
+        levelIndices = mesh.lods[0].indexCount;
+    }
+    if (levelIndices / 3 < MESHLET_MIN_TRIANGLES)
+        return;
+
+    if (rangeCount == 0) {
+        partitionRange(mesh.vertices, mesh.indices.data(), levelIndices, 0, mesh.meshlets);
+    }
+    else {
+        for (uint32_t r = firstRange; r < firstRange + rangeCount; r++) {
+            const MeshRange& range = mesh.ranges[r];
+            partitionRange(mesh.vertices, mesh.indices.data() + range.firstIndex, range.indexCount,
+                           range.firstIndex, mesh.meshlets);
+        }
+    }
+
+    // A ordem dos triângulos mudou: a leitura de vértices volta a ser sequencial
+    optimizeVertexFetch(mesh);
+
+    size_t cullable = 0;
+    for (const Meshlet& m : mesh.meshlets)
+        cullable += m.coneCutoff < 1.0f;
+
+    cout << "Meshlets";
+    if (name)
+        cout << " (" << name << ")";
+    cout << ": " << mesh.meshlets.size() << " grupos, média de "
+         << (double)levelIndices / 3 / max<size_t>(mesh.meshlets.size(), 1) << " triângulos; "
+         << cullable << " com cone de normais utilizável" << endl;
+}
+
+void cullMeshlets(const GpuMesh& mesh, const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition,
+                  MeshletDrawList& out)
+{
+    out.counts.clear();
+    out.offsets.clear();
+    out.materials.clear();
+    out.stats = MeshletStats();
+
+    size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    size_t rangeCount;
+    const MeshRange* ranges = meshLodRanges(mesh, 0, rangeCount);
+
+    // Trechos vizinhos no EBO e do mesmo material viram um único trecho
+    uint32_t lastEnd = UINT32_MAX;
+    auto append = [&](uint32_t firstIndex, uint32_t indexCount, int32_t material) {
+        if (firstIndex == lastEnd && out.materials.back() == material) {
+            out.counts.back() += indexCount;
+        }
+        else {
+            out.counts.push_back(indexCount);
+            out.offsets.push_back((const GLvoid*)(uintptr_t)(firstIndex * indexSize));
+            out.materials.push_back(material);
+        }
+        lastEnd = firstIndex + indexCount;
+    };
+
+    if (mesh.meshlets.empty()) {
+        MeshLod lod = meshLod(mesh, 0);
+        if (rangeCount == 0)
+            append(lod.firstIndex, lod.indexCount, -1);
+        for (size_t r = 0; r < rangeCount; r++)
+            append(ranges[r].firstIndex, ranges[r].indexCount, ranges[r].material);
+        out.stats.triangles = out.stats.visibleTriangles = lod.indexCount / 3;
+        return;
+    }
+
+    glm::vec4 planes[6];
+    extractFrustum(modelViewProjection, planes);
+
+    // Os meshlets seguem a ordem das faixas no EBO; a caixa de cada faixa é
+    // testada uma vez e, fora do frustum, descarta todos os meshlets dela
+    size_t r = 0, testedRange = SIZE_MAX;
+    bool rangeOutside = false;
+    for (const Meshlet& m : mesh.meshlets) {
+        out.stats.meshlets++;
+        out.stats.triangles += m.indexCount / 3;
+
+        while (r + 1 < rangeCount && m.firstIndex >= ranges[r].firstIndex + ranges[r].indexCount)
+            ++r;
+        if (rangeCount > 0 && r != testedRange) {
+            testedRange = r;
+            rangeOutside = boxOutside(planes, ranges[r].boundsMin, ranges[r].boundsMax);
+            out.stats.rangesOutside += rangeOutside;
+        }
+
+        bool outside = rangeOutside;
+        for (int i = 0; i < 6 && !outside; i++)
+            outside = glm::dot(glm::vec3(planes[i]), m.center) + planes[i].w < -m.radius;
+        if (outside) {
+            out.stats.outside++;
+            continue;
+        }
+
+        if (m.coneCutoff < 1.0f) {
+            glm::vec3 view = m.coneApex - cameraPosition;
+            float length = glm::length(view);
+            if (length > 0.0f && glm::dot(view / length, m.coneAxis) >= m.coneCutoff) {
+                out.stats.backfacing++;
+                continue;
+            }
+        }
+
+        out.stats.visibleMeshlets++;
+        out.stats.visibleTriangles += m.indexCount / 3;
+        append(m.firstIndex, m.indexCount, rangeCount > 0 ? ranges[r].material : -1);
+    }
+}
+
+void drawMeshlets(const GpuMesh& mesh, const MeshletDrawList& list, bool positionsOnly,
+                  const MaterialBinder& bindMaterial)
+{
+    if (list.counts.empty())
+        return;
+
+    glBindVertexArray(positionsOnly ? mesh.positionVAO : mesh.VAO);
+    // Mesma cor constante de drawMesh quando não há fluxo de cor
+    if (!positionsOnly && mesh.format.color == COLOR_NONE)
+        glVertexAttrib4f(1, mesh.color.r, mesh.color.g, mesh.color.b, 1.0f);
+
+    if (positionsOnly || !bindMaterial) {
+        glMultiDrawElements(GL_TRIANGLES, list.counts.data(), mesh.indexType, list.offsets.data(),
+                            (GLsizei)list.counts.size());
+    }
+    else {
+        // Os trechos de um mesmo material são vizinhos: um glMultiDrawElements por material
+        size_t count = list.counts.size();
+        for (size_t i = 0; i < count;) {
+            size_t next = i + 1;
+            while (next < count && list.materials[next] == list.materials[i])
+                ++next;
+            bindMaterial(list.materials[i]);
+            glMultiDrawElements(GL_TRIANGLES, list.counts.data() + i, mesh.indexType, list.offsets.data() + i,
+                                (GLsizei)(next - i));
+            i = next;
+        }
+    }
+    glBindVertexArray(0);
+}
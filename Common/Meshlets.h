@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+// Limites de cada meshlet (grupo de triângulos vizinhos desenhado como um trecho
+// contíguo do EBO)
+const unsigned MESHLET_MAX_VERTICES = 64;
+const unsigned MESHLET_MAX_TRIANGLES = 124;
+
+// Malhas com menos triângulos que isto no nível 0 não são divididas
+const unsigned MESHLET_MIN_TRIANGLES = 2 * MESHLET_MAX_TRIANGLES;
+
+// Estatísticas de montagem e de descarte dos meshlets
+struct MeshletStats
+{
+    size_t meshlets = 0;
+    size_t triangles = 0;
+    size_t visibleMeshlets = 0;
+    size_t visibleTriangles = 0;
+    size_t backfacing = 0; // meshlets descartados pelo cone de normais
+    size_t outside = 0;    // meshlets descartados pelo frustum
+    size_t rangesOutside = 0; // faixas de material inteiras fora do frustum pela caixa
+};
+
+// Trechos visíveis prontos para glMultiDrawElements; meshlets visíveis vizinhos
+// no EBO e do mesmo material são unidos em um único trecho
+struct MeshletDrawList
+{
+    std::vector<GLsizei> counts;
+    std::vector<const GLvoid*> offsets;
+    std::vector<int32_t> materials; // MeshRange::material de cada trecho
+    MeshletStats stats;
+};
+
+// Divide o nível 0 de cada faixa de material em meshlets e reordena os índices
+// da faixa para que cada meshlet fique contíguo. Os triângulos crescem a partir
+// de uma semente preferindo os que reaproveitam vértices do meshlet e têm
+// normal parecida com a dele, o que deixa o cone de normais estreito. Dentro
+// de cada meshlet os triângulos seguem o Tipsify; os meshlets seguem a ordem
+// contra overdraw de optimizeOverdraw, e os vértices são renumerados no fim
+// (optimizeVertexFetch).
+void buildMeshlets(IndexedMesh& mesh, const char* name = nullptr);
+
+// Esfera envolvente e cone de normais de um trecho de triângulos
+void computeMeshletBounds(const std::vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount,
+                          Meshlet& meshlet);
+
+// Testa cada meshlet contra o frustum de `modelViewProjection` e contra a
+// câmera (`cameraPosition` no espaço do objeto) pelo cone de normais; antes,
+// a caixa de cada faixa de material descarta de uma vez os meshlets dela.
+// Malhas sem meshlets geram um trecho por material com o nível 0 inteiro.
+void cullMeshlets(const GpuMesh& mesh, const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition,
+                  MeshletDrawList& out);
+
+// Desenha os trechos visíveis com todos os fluxos ou só com o de posição. Com
+// `bindMaterial` (ignorado com `positionsOnly`), sai um glMultiDrawElements
+// por material, precedido da chamada ao callback.
+void drawMeshlets(const GpuMesh& mesh, const MeshletDrawList& list, bool positionsOnly = false,
+                  const MaterialBinder& bindMaterial = nullptr);
@@ -0,0 +1,314 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIP_GENERATOR_AVX2 1
+#endif
+
+using namespace std;
+
+namespace {
+
+// Abaixo deste número de pixels no nível o custo de criar threads supera o ganho
+const size_t kMinParallelPixels = 64 * 1024;
+
+// Janela de Kaiser sobre um sinc, em pixels do nível de destino
+const float KAISER_WIDTH = 3.0f;
+const float KAISER_ALPHA = 4.0f;
+
+// Resolução da tabela linear -> 8 bits (14 bits preservam os tons escuros do sRGB)
+const int LINEAR_STEPS = 16383;
+
+// Conversões por tabela: 8 bits -> linear e linear quantizado -> 8 bits
+struct ColorTables
+{
+    float toLinear[256];
+    uint8_t fromLinear[LINEAR_STEPS + 1];
+};
+
+ColorTables makeTables(bool srgb)
+{
+    ColorTables tables;
+    for (int i = 0; i < 256; i++) {
+        float c = i / 255.0f;
+        tables.toLinear[i] = !srgb ? c : c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (int i = 0; i <= LINEAR_STEPS; i++) {
+        float l = (float)i / LINEAR_STEPS;
+        float c = !srgb ? l : l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+        tables.fromLinear[i] = (uint8_t)lrintf(c * 255.0f);
+    }
+    return tables;
+}
+
+const ColorTables& colorTables(bool srgb)
+{
+    static const ColorTables srgbTables = makeTables(true);
+    static const ColorTables linearTables = makeTables(false);
+    return srgb ? srgbTables : linearTables;
+}
+
+// Linha RGBA8 -> floats lineares (o alfa sempre direto)
+void decodeRow(const uint8_t* src, uint32_t width, const ColorTables& tables, float* out)
+{
+    for (uint32_t x = 0; x < width; x++) {
+        out[x * 4 + 0] = tables.toLinear[src[x * 4 + 0]];
+        out[x * 4 + 1] = tables.toLinear[src[x * 4 + 1]];
+        out[x * 4 + 2] = tables.toLinear[src[x * 4 + 2]];
+        out[x * 4 + 3] = src[x * 4 + 3] * (1.0f / 255.0f);
+    }
+}
+
+// Floats lineares -> linha RGBA8, com saturação em [0, 1] (o Kaiser tem lóbulos negativos)
+void encodeRow(const float* in, uint32_t width, const ColorTables& tables, uint8_t* out)
+{
+#ifdef MIP_GENERATOR_SSE2
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_setr_ps((float)LINEAR_STEPS, (float)LINEAR_STEPS, (float)LINEAR_STEPS, 255.0f);
+    alignas(16) int32_t q[4];
+    for (uint32_t x = 0; x < width; x++) {
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + x * 4), zero), one);
+        _mm_store_si128(reinterpret_cast<__m128i*>(q), _mm_cvtps_epi32(_mm_mul_ps(v, scale)));
+        out[x * 4 + 0] = tables.fromLinear[q[0]];
+        out[x * 4 + 1] = tables.fromLinear[q[1]];
+        out[x * 4 + 2] = tables.fromLinear[q[2]];
+        out[x * 4 + 3] = (uint8_t)q[3];
+    }
+#else
+    for (uint32_t x = 0; x < width; x++) {
+        for (int c = 0; c < 3; c++)
+            out[x * 4 + c] = tables.fromLinear[lrintf(clamp(in[x * 4 + c], 0.0f, 1.0f) * LINEAR_STEPS)];
+        out[x * 4 + 3] = (uint8_t)lrintf(clamp(in[x * 4 + 3], 0.0f, 1.0f) * 255.0f);
+    }
+#endif
+}
+
+// out += weight * in, em `count` floats contíguos
+void accumulateRow(float* out, const float* in, float weight, size_t count)
+{
+    size_t i = 0;
+#if defined(MIP_GENERATOR_AVX2)
+    const __m256 w8 = _mm256_set1_ps(weight);
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), w8));
+        _mm256_storeu_ps(out + i, sum);
+    }
+#endif
+#ifdef MIP_GENERATOR_SSE2
+    const __m128 w4 = _mm_set1_ps(weight);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), w4)));
+#endif
+    for (; i < count; i++)
+        out[i] += weight * in[i];
+}
+
+// Pesos de cada pixel de destino: `taps` pixels de origem a partir de
+// first[i], com as bordas repetidas (índices fora da imagem são saturados)
+struct FilterTaps
+{
+    int taps = 0;
+    vector<int> first;
+    vector<float> weights; // taps por pixel de destino
+};
+
+float besselI0(float x)
+{
+    // Série de potências; converge rápido para os argumentos da janela
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 20; k++) {
+        term *= (x * 0.5f / k) * (x * 0.5f / k);
+        sum += term;
+    }
+    return sum;
+}
+
+float kaiserSinc(float d)
+{
+    float t = d / KAISER_WIDTH;
+    if (fabsf(t) >= 1.0f)
+        return 0.0f;
+    float window = besselI0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / besselI0(KAISER_ALPHA);
+    float x = (float)M_PI * d;
+    return (fabsf(x) < 1e-6f ? 1.0f : sinf(x) / x) * window;
+}
+
+FilterTaps makeKaiserTaps(uint32_t srcSize, uint32_t dstSize)
+{
+    FilterTaps f;
+    float ratio = (float)srcSize / dstSize;
+    float support = KAISER_WIDTH * ratio;
+    f.taps = (int)ceilf(support * 2.0f) + 1;
+    f.first.resize(dstSize);
+    f.weights.resize((size_t)dstSize * f.taps);
+    for (uint32_t i = 0; i < dstSize; i++) {
+        float center = (i + 0.5f) * ratio;
+        f.first[i] = (int)floorf(center - support);
+        float* w = &f.weights[(size_t)i * f.taps];
+        float sum = 0.0f;
+        for (int k = 0; k < f.taps; k++) {
+            w[k] = kaiserSinc((f.first[i] + k + 0.5f - center) / ratio);
+            sum += w[k];
+        }
+        for (int k = 0; k < f.taps; k++)
+            w[k] /= sum;
+    }
+    return f;
+}
+
+struct LevelJob
+{
+    const uint8_t* src;
+    uint32_t srcWidth, srcHeight;
+    uint8_t* dst;
+    uint32_t dstWidth, dstHeight;
+    const ColorTables* tables;
+};
+
+// Média 2x2 (com a última linha/coluna repetida nas dimensões ímpares)
+void boxRows(const LevelJob& job, uint32_t firstRow, uint32_t lastRow)
+{
+    vector<float> row0((size_t)job.srcWidth * 4), row1((size_t)job.srcWidth * 4), out((size_t)job.dstWidth * 4);
+    for (uint32_t y = firstRow; y < lastRow; y++) {
+        uint32_t y0 = min(y * 2, job.srcHeight - 1), y1 = min(y * 2 + 1, job.srcHeight - 1);
+        decodeRow(job.src + (size_t)y0 * job.srcWidth * 4, job.srcWidth, *job.tables, row0.data());
+        decodeRow(job.src + (size_t)y1 * job.srcWidth * 4, job.srcWidth, *job.tables, row1.data());
+        accumulateRow(row0.data(), row1.data(), 1.0f, row0.size());
+
+        for (uint32_t x = 0; x < job.dstWidth; x++) {
+            const float* a = &row0[(size_t)min(x * 2, job.srcWidth - 1) * 4];
+            const float* b = &row0[(size_t)min(x * 2 + 1, job.srcWidth - 1) * 4];
+#ifdef MIP_GENERATOR_SSE2
+            _mm_storeu_ps(&out[x * 4], _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)), _mm_set1_ps(0.25f)));
+#else
+            for (int c = 0; c < 4; c++)
+                out[x * 4 + c] = (a[c] + b[c]) * 0.25f;
+#endif
+        }
+        encodeRow(out.data(), job.dstWidth, *job.tables, job.dst + (size_t)y * job.dstWidth * 4);
+    }
+}
+
+// Kaiser separável: cada linha de origem é filtrada na horizontal uma vez (em
+// um anel de linhas reaproveitadas pelas linhas vizinhas de destino) e as
+// linhas filtradas são somadas na vertical
+void kaiserRows(const LevelJob& job, const FilterTaps& horizontal, const FilterTaps& vertical, uint32_t firstRow,
+                uint32_t lastRow)
+{
+    size_t rowFloats = (size_t)job.dstWidth * 4;
+    vector<float> decoded((size_t)job.srcWidth * 4), out(rowFloats);
+    vector<vector<float>> ring(vertical.taps, vector<float>(rowFloats));
+    vector<int> ringRow(vertical.taps, -1);
+    vector<const float*> window(vertical.taps);
+
+    auto filteredRow = [&](int sy) -> const float* {
+        size_t slot = (size_t)sy % ring.size();
+        if (ringRow[slot] == sy)
+            return ring[slot].data();
+        decodeRow(job.src + (size_t)sy * job.srcWidth * 4, job.srcWidth, *job.tables, decoded.data());
+        float* h = ring[slot].data();
+        for (uint32_t x = 0; x < job.dstWidth; x++) {
+            const float* w = &horizontal.weights[(size_t)x * horizontal.taps];
+            int first = horizontal.first[x];
+#ifdef MIP_GENERATOR_SSE2
+            __m128 sum = _mm_setzero_ps();
+            for (int k = 0; k < horizontal.taps; k++) {
+                int sx = clamp(first + k, 0, (int)job.srcWidth - 1);
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&decoded[(size_t)sx * 4]), _mm_set1_ps(w[k])));
+            }
+            _mm_storeu_ps(h + x * 4, sum);
+#else
+            float sum[4] = {};
+            for (int k = 0; k < horizontal.taps; k++) {
+                int sx = clamp(first + k, 0, (int)job.srcWidth - 1);
+                for (int c = 0; c < 4; c++)
+                    sum[c] += decoded[(size_t)sx * 4 + c] * w[k];
+            }
+            memcpy(h + x * 4, sum, sizeof(sum));
+#endif
+        }
+        ringRow[slot] = sy;
+        return h;
+    };
+
+    for (uint32_t y = firstRow; y < lastRow; y++) {
+        // As linhas da janela são distintas módulo o tamanho do anel, então
+        // buscar todas antes de somar não sobrescreve nenhuma
+        const float* w = &vertical.weights[(size_t)y * vertical.taps];
+        for (int k = 0; k < vertical.taps; k++)
+            window[k] = filteredRow(clamp(vertical.first[y] + k, 0, (int)job.srcHeight - 1));
+        fill(out.begin(), out.end(), 0.0f);
+        for (int k = 0; k < vertical.taps; k++)
+            accumulateRow(out.data(), window[k], w[k], rowFloats);
+        encodeRow(out.data(), job.dstWidth, *job.tables, job.dst + (size_t)y * job.dstWidth * 4);
+    }
+}
+
+// Executa job(i) para cada faixa, uma faixa por thread
+template <typename Job>
+void runBands(size_t bands, Job job)
+{
+    vector<thread> workers;
+    workers.reserve(bands - 1);
+    for (size_t i = 1; i < bands; i++)
+        workers.emplace_back(job, i);
+    job(0);
+    for (thread& t : workers)
+        t.join();
+}
+
+} // namespace
+
+const char* mipFilterName(MipFilter filter)
+{
+    return filter == MIP_FILTER_KAISER ? "Kaiser" : "caixa";
+}
+
+void generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, const MipOptions& options,
+                      vector<TextureLevel>& levels, vector<uint8_t>& data)
+{
+    // Todos os níveis alocados de uma vez, para os ponteiros não mudarem
+    levels.clear();
+    uint64_t total = 0;
+    for (uint32_t w = width, h = height;; w = max(1u, w / 2), h = max(1u, h / 2)) {
+        levels.push_back(TextureLevel{ w, h, total, (uint64_t)w * h * 4 });
+        total += levels.back().size;
+        if (w == 1 && h == 1)
+            break;
+    }
+    data.resize(total);
+    memcpy(data.data(), rgba, levels[0].size);
+
+    unsigned threads = options.threads ? options.threads : max(1u, thread::hardware_concurrency());
+    const ColorTables& tables = colorTables(options.srgb);
+    for (size_t i = 1; i < levels.size(); i++) {
+        const TextureLevel& src = levels[i - 1];
+        const TextureLevel& dst = levels[i];
+        LevelJob job{ data.data() + src.offset, src.width, src.height, data.data() + dst.offset, dst.width,
+                      dst.height, &tables };
+
+        size_t bands = (size_t)dst.width * dst.height < kMinParallelPixels ? 1 : min<size_t>(threads, dst.height);
+        if (options.filter == MIP_FILTER_KAISER) {
+            FilterTaps horizontal = makeKaiserTaps(src.width, dst.width);
+            FilterTaps vertical = makeKaiserTaps(src.height, dst.height);
+            runBands(bands, [&](size_t band) {
+                kaiserRows(job, horizontal, vertical, (uint32_t)(dst.height * band / bands),
+                           (uint32_t)(dst.height * (band + 1) / bands));
+            });
+        }
+        else {
+            runBands(bands, [&](size_t band) {
+                boxRows(job, (uint32_t)(dst.height * band / bands), (uint32_t)(dst.height * (band + 1) / bands));
+            });
+        }
+    }
+}
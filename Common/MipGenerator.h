@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Um nível de mip dentro de um buffer de dados
+struct TextureLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset; // a partir do início dos dados (ou do arquivo, no .ctex)
+    uint64_t size;
+};
+
+enum MipFilter : uint32_t
+{
+    MIP_FILTER_BOX = 0,    // média 2x2 (a mesma do glGenerateMipmap)
+    MIP_FILTER_KAISER = 1, // sinc com janela de Kaiser (largura 3, alfa 4): mips mais nítidos
+};
+
+struct MipOptions
+{
+    MipFilter filter = MIP_FILTER_BOX;
+    bool srgb = true;     // RGB em sRGB: converte para linear antes de filtrar (o alfa já é linear)
+    unsigned threads = 0; // 0 = número de núcleos
+};
+
+const char* mipFilterName(MipFilter filter);
+
+// Gera a cadeia completa de mips de uma imagem RGBA8, do nível 0 (cópia de
+// `rgba`) até 1x1, em `data`. Cada nível sai do anterior, filtrado em ponto
+// flutuante; as linhas de cada nível são divididas em faixas entre as
+// threads, e os laços internos usam SSE2 (e AVX2, se compilado com ele).
+void generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, const MipOptions& options,
+                      std::vector<TextureLevel>& levels, std::vector<uint8_t>& data);
@@ -0,0 +1,578 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+// Quantidade de registros de cada tipo em um trecho do arquivo
+struct ObjCounts
+{
+    size_t v = 0;
+    size_t vc = 0; // linhas "v" com cor (extensão "v x y z r g b")
+    size_t vt = 0;
+    size_t vn = 0;
+    size_t tris = 0;
+};
+
+enum LineType
+{
+    LINE_OTHER,
+    LINE_V,
+    LINE_VT,
+    LINE_VN,
+    LINE_F,
+    LINE_USEMTL,
+    LINE_GROUP, // "o" ou "g"
+    LINE_MTLLIB
+};
+
+// Linha usemtl, o/g ou mtllib encontrada na contagem, com o número de
+// triângulos do bloco que a antecedem
+struct ObjMark
+{
+    size_t tris;
+    LineType type;
+    string name;
+};
+
+// Potências de 10 representáveis exatamente em double
+const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && isSpace(*p))
+        ++p;
+    return p;
+}
+
+inline const char* findLineEnd(const char* p, const char* end)
+{
+    const void* nl = memchr(p, '\n', end - p);
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+// Depois de "v", diz se a linha traz uma cor: exatamente seis números
+// ("v x y z r g b"); "v x y z w" e outras contagens não têm cor
+inline bool hasVertexColor(const char* p, const char* end)
+{
+    int tokens = 0;
+    for (;;) {
+        p = skipSpaces(p, end);
+        if (p >= end || *p == '#')
+            break;
+        while (p < end && !isSpace(*p))
+            ++p;
+        tokens++;
+    }
+    return tokens == 6;
+}
+
+// Identifica a palavra-chave da linha e avança `p` para depois dela
+inline LineType classifyLine(const char*& p, const char* end)
+{
+    p = skipSpaces(p, end);
+    if (end - p < 2)
+        return LINE_OTHER;
+
+    if (p[0] == 'v') {
+        if (isSpace(p[1])) {
+            p += 1;
+            return LINE_V;
+        }
+        if (end - p >= 3 && isSpace(p[2])) {
+            if (p[1] == 't') {
+                p += 2;
+                return LINE_VT;
+            }
+            if (p[1] == 'n') {
+                p += 2;
+                return LINE_VN;
+            }
+        }
+    }
+    else if (p[0] == 'f' && isSpace(p[1])) {
+        p += 1;
+        return LINE_F;
+    }
+    else if ((p[0] == 'o' || p[0] == 'g') && isSpace(p[1])) {
+        p += 1;
+        return LINE_GROUP;
+    }
+    else if (end - p >= 7 && isSpace(p[6])) {
+        if (memcmp(p, "usemtl", 6) == 0) {
+            p += 6;
+            return LINE_USEMTL;
+        }
+        if (memcmp(p, "mtllib", 6) == 0) {
+            p += 6;
+            return LINE_MTLLIB;
+        }
+    }
+    return LINE_OTHER;
+}
+
+// Conversão de texto para float sem locale nem alocação. Mantém até 19 dígitos
+// significativos e usa a tabela exata de potências de 10 sempre que possível.
+inline const char* parseFloat(const char* p, const char* end, float& out)
+{
+    p = skipSpaces(p, end);
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+
+    while (p < end && isDigit(*p)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa)
+                ++digits;
+        }
+        else {
+            ++exponent;
+        }
+        any = true;
+        ++p;
+    }
+
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && isDigit(*p)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa)
+                    ++digits;
+                --exponent;
+            }
+            any = true;
+            ++p;
+        }
+    }
+
+    if (!any) {
+        out = 0.0f;
+        return p;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExp = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            negativeExp = *q == '-';
+            ++q;
+        }
+        if (q < end && isDigit(*q)) {
+            int e = 0;
+            while (q < end && isDigit(*q)) {
+                if (e < 10000)
+                    e = e * 10 + (*q - '0');
+                ++q;
+            }
+            exponent += negativeExp ? -e : e;
+            p = q;
+        }
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0)
+        value = exponent >= -22 ? value / kPow10[-exponent] : value * pow(10.0, exponent);
+    else if (exponent > 0)
+        value = exponent <= 22 ? value * kPow10[exponent] : value * pow(10.0, exponent);
+
+    out = static_cast<float>(negative ? -value : value);
+    return p;
+}
+
+// Lê um inteiro com sinal; `found` indica se havia algum dígito
+inline const char* parseInt(const char* p, const char* end, long& out, bool& found)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    long value = 0;
+    found = false;
+    while (p < end && isDigit(*p)) {
+        value = value * 10 + (*p - '0');
+        found = true;
+        ++p;
+    }
+
+    out = negative ? -value : value;
+    return p;
+}
+
+// Converte um índice do OBJ (base 1, ou negativo relativo ao último elemento
+// lido) para base 0. Índices positivos são validados contra o total do arquivo.
+inline bool resolveIndex(long index, size_t readSoFar, size_t total, int& out)
+{
+    if (index > 0 && static_cast<size_t>(index) <= total) {
+        out = static_cast<int>(index - 1);
+        return true;
+    }
+    if (index < 0 && static_cast<size_t>(-index) <= readSoFar) {
+        out = static_cast<int>(static_cast<long>(readSoFar) + index);
+        return true;
+    }
+    return false;
+}
+
+// Número de cantos (tokens) de uma linha de face
+inline size_t countFaceCorners(const char* p, const char* end)
+{
+    size_t corners = 0;
+    while (true) {
+        p = skipSpaces(p, end);
+        if (p >= end || *p == '#')
+            break;
+        ++corners;
+        while (p < end && !isSpace(*p))
+            ++p;
+    }
+    return corners;
+}
+
+// Resto da linha sem espaços nas pontas nem comentário
+string readName(const char* p, const char* end)
+{
+    p = skipSpaces(p, end);
+    const char* last = p;
+    for (const char* c = p; c < end && *c != '#'; ++c)
+        if (!isSpace(*c))
+            last = c + 1;
+    return string(p, last);
+}
+
+size_t lineNumberAt(const char* fileStart, const char* p)
+{
+    size_t line = 1;
+    for (const char* c = fileStart; c < p; ++c)
+        if (*c == '\n')
+            ++line;
+    return line;
+}
+
+// Primeira passada: conta os registros do trecho [begin, end) e anota as
+// linhas de material e de objeto, que são poucas
+void countRecords(const char* begin, const char* end, const ObjLoadOptions& options, ObjCounts& counts,
+                  vector<ObjMark>& marks)
+{
+    const char* p = begin;
+    while (p < end) {
+        const char* eol = findLineEnd(p, end);
+        const char* q = p;
+        LineType type = classifyLine(q, eol);
+        switch (type) {
+            case LINE_V:
+                ++counts.v;
+                if (hasVertexColor(q, eol))
+                    ++counts.vc;
+                break;
+            case LINE_VT:
+                ++counts.vt;
+                break;
+            case LINE_VN:
+                ++counts.vn;
+                break;
+            case LINE_F: {
+                size_t corners = countFaceCorners(q, eol);
+                if (corners >= 3)
+                    counts.tris += corners - 2;
+                break;
+            }
+            case LINE_USEMTL:
+            case LINE_GROUP:
+            case LINE_MTLLIB:
+                marks.push_back(ObjMark{ counts.tris, type, readName(q, eol) });
+                if (type == LINE_MTLLIB && options.onMaterialLibrary && !marks.back().name.empty())
+                    options.onMaterialLibrary(marks.back().name);
+                break;
+            default:
+                break;
+        }
+        p = eol + 1;
+    }
+}
+
+// Segunda passada: escreve os registros do trecho [begin, end) em `out`, a partir
+// das posições indicadas por `base` (quantos registros vêm antes do trecho).
+bool parseRecords(const char* fileStart, const char* begin, const char* end,
+                  const ObjCounts& base, const ObjCounts& totals, ObjData& out)
+{
+    size_t v = base.v, vt = base.vt, vn = base.vn;
+    ObjIndex* corner = out.corners.data() + base.tris * 3;
+
+    const char* p = begin;
+    while (p < end) {
+        const char* eol = findLineEnd(p, end);
+        const char* q = p;
+        switch (classifyLine(q, eol)) {
+            case LINE_V: {
+                glm::vec3& pos = out.positions[v];
+                bool colored = !out.colors.empty() && hasVertexColor(q, eol);
+                q = parseFloat(q, eol, pos.x);
+                q = parseFloat(q, eol, pos.y);
+                q = parseFloat(q, eol, pos.z);
+                if (colored) {
+                    glm::vec3& color = out.colors[v];
+                    q = parseFloat(q, eol, color.r);
+                    q = parseFloat(q, eol, color.g);
+                    parseFloat(q, eol, color.b);
+                }
+                v++;
+                break;
+            }
+            case LINE_VT: {
+                glm::vec2& uv = out.uvs[vt++];
+                q = parseFloat(q, eol, uv.x);
+                parseFloat(q, eol, uv.y);
+                break;
+            }
+            case LINE_VN: {
+                glm::vec3& n = out.normals[vn++];
+                q = parseFloat(q, eol, n.x);
+                q = parseFloat(q, eol, n.y);
+                parseFloat(q, eol, n.z);
+                break;
+            }
+            case LINE_F: {
+                ObjIndex first = {}, previous = {};
+                size_t count = 0;
+                while (true) {
+                    q = skipSpaces(q, eol);
+                    if (q >= eol || *q == '#')
+                        break;
+
+                    ObjIndex idx = { -1, -1, -1 };
+                    long value;
+                    bool found;
+                    bool ok = true;
+
+                    q = parseInt(q, eol, value, found);
+                    ok = found && resolveIndex(value, v, totals.v, idx.v);
+                    if (ok && q < eol && *q == '/') {
+                        ++q;
+                        q = parseInt(q, eol, value, found);
+                        if (found)
+                            ok = resolveIndex(value, vt, totals.vt, idx.vt);
+                        if (ok && q < eol && *q == '/') {
+                            ++q;
+                            q = parseInt(q, eol, value, found);
+                            if (found)
+                                ok = resolveIndex(value, vn, totals.vn, idx.vn);
+                        }
+                    }
+                    if (!ok || (q < eol && !isSpace(*q))) {
+                        cout << "Arquivo OBJ com face inválida na linha " << lineNumberAt(fileStart, p) << endl;
+                        return false;
+                    }
+
+                    // Triangulação em leque: (0, i-1, i)
+                    if (count == 0) {
+                        first = idx;
+                    }
+                    else if (count >= 2) {
+                        *corner++ = first;
+                        *corner++ = previous;
+                        *corner++ = idx;
+                    }
+                    previous = idx;
+                    ++count;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        p = eol + 1;
+    }
+    return true;
+}
+
+// Converte as marcas de todos os blocos (já com o número global de triângulos)
+// nos grupos de material e objeto. Grupos vazios são substituídos pelo seguinte.
+void buildGroups(const vector<ObjMark>& marks, ObjData& out)
+{
+    out.materials.clear();
+    out.objects.clear();
+    out.materialLibs.clear();
+    out.groups.clear();
+
+    unordered_map<string, int32_t> materialIds, objectIds;
+    ObjGroup current = { 0, -1, -1 };
+    for (const ObjMark& mark : marks) {
+        if (mark.type == LINE_MTLLIB) {
+            if (!mark.name.empty())
+                out.materialLibs.push_back(mark.name);
+            continue;
+        }
+
+        auto& ids = mark.type == LINE_USEMTL ? materialIds : objectIds;
+        auto& names = mark.type == LINE_USEMTL ? out.materials : out.objects;
+        auto found = ids.emplace(mark.name, (int32_t)names.size());
+        if (found.second)
+            names.push_back(mark.name);
+        (mark.type == LINE_USEMTL ? current.material : current.object) = found.first->second;
+
+        current.firstTriangle = (uint32_t)mark.tris;
+        if (!out.groups.empty() && out.groups.back().firstTriangle == current.firstTriangle)
+            out.groups.back() = current;
+        else
+            out.groups.push_back(current);
+    }
+
+    // Triângulos antes do primeiro usemtl/o/g ficam sem material nem objeto
+    if (!out.groups.empty() && out.groups.front().firstTriangle > 0)
+        out.groups.insert(out.groups.begin(), ObjGroup{ 0, -1, -1 });
+}
+
+// Abaixo deste tamanho de bloco o custo de criar threads supera o ganho
+const size_t kMinChunkBytes = 256 * 1024;
+
+// Divide [begin, end) em até `count` blocos que terminam logo após um '\n'
+vector<const char*> splitChunks(const char* begin, const char* end, size_t count)
+{
+    vector<const char*> bounds;
+    bounds.reserve(count + 1);
+    bounds.push_back(begin);
+
+    size_t size = end - begin;
+    for (size_t i = 1; i < count; i++) {
+        const char* cut = begin + size * i / count;
+        if (cut < bounds.back())
+            cut = bounds.back();
+        cut = findLineEnd(cut, end);
+        if (cut < end)
+            ++cut;
+        if (cut > bounds.back() && cut < end)
+            bounds.push_back(cut);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// Executa job(i) para cada bloco, um bloco por thread
+template <typename Job>
+void runChunks(size_t chunks, Job job)
+{
+    vector<thread> workers;
+    workers.reserve(chunks - 1);
+    for (size_t i = 1; i < chunks; i++)
+        workers.emplace_back(job, i);
+    job(0);
+    for (thread& t : workers)
+        t.join();
+}
+
+} // namespace
+
+bool parseOBJ(const char* path, ObjData& out, const ObjLoadOptions& options)
+{
+    auto start = chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.open(path)) {
+        cout << "Erro ao abrir o arquivo OBJ: " << path << endl;
+        return false;
+    }
+
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    size_t threads = options.threads ? options.threads : max(1u, thread::hardware_concurrency());
+    threads = max<size_t>(1, min(threads, file.size() / kMinChunkBytes));
+
+    vector<const char*> bounds = splitChunks(begin, end, threads);
+    size_t chunks = bounds.size() - 1;
+
+    // Passada 1: contagem por bloco
+    vector<ObjCounts> counts(chunks);
+    vector<vector<ObjMark>> chunkMarks(chunks);
+    runChunks(chunks, [&](size_t i) {
+        countRecords(bounds[i], bounds[i + 1], options, counts[i], chunkMarks[i]);
+    });
+
+    // Soma de prefixos: quantos registros de cada tipo antecedem cada bloco
+    vector<ObjCounts> bases(chunks);
+    ObjCounts totals;
+    for (size_t i = 0; i < chunks; i++) {
+        bases[i] = totals;
+        totals.v += counts[i].v;
+        totals.vc += counts[i].vc;
+        totals.vt += counts[i].vt;
+        totals.vn += counts[i].vn;
+        totals.tris += counts[i].tris;
+    }
+
+    out.positions.assign(totals.v, glm::vec3(0.0f));
+    // Vértices sem cor em um arquivo que tem cores ficam brancos
+    out.colors.assign(totals.vc ? totals.v : 0, glm::vec3(1.0f));
+    out.uvs.assign(totals.vt, glm::vec2(0.0f));
+    out.normals.assign(totals.vn, glm::vec3(0.0f));
+    out.corners.resize(totals.tris * 3);
+
+    vector<ObjMark> marks;
+    for (size_t i = 0; i < chunks; i++) {
+        for (ObjMark& mark : chunkMarks[i]) {
+            mark.tris += bases[i].tris;
+            marks.push_back(std::move(mark));
+        }
+    }
+    buildGroups(marks, out);
+
+    // Passada 2: cada bloco escreve direto na sua faixa dos vetores de saída
+    vector<char> ok(chunks, 1);
+    runChunks(chunks, [&](size_t i) {
+        ok[i] = parseRecords(begin, bounds[i], bounds[i + 1], bases[i], totals, out);
+    });
+    for (char chunkOk : ok)
+        if (!chunkOk)
+            return false;
+
+    if (options.printStats) {
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "OBJ carregado: " << path << " (" << totals.v << " vértices, "
+             << totals.tris << " triângulos, " << out.materials.size() << " materiais, " << out.groups.size()
+             << " grupos) em " << ms << " ms com "
+             << chunks << (chunks == 1 ? " thread" : " threads") << endl;
+    }
+    return true;
+}
+
+glm::vec3 objFaceNormal(const ObjData& obj, const ObjIndex* c)
+{
+    glm::vec3 cr = glm::cross(obj.positions[c[1].v] - obj.positions[c[0].v],
+                              obj.positions[c[2].v] - obj.positions[c[0].v]);
+    float len = glm::length(cr);
+    return len > 0.0f ? cr / len : glm::vec3(0.0f, 0.0f, 1.0f);
+}
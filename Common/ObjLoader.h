@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Índices de um canto de face, já convertidos para base 0 (-1 = atributo ausente)
+struct ObjIndex
+{
+    int v;
+    int vt;
+    int vn;
+};
+
+// Trecho de triângulos com o mesmo "usemtl" e o mesmo "o"/"g", de
+// `firstTriangle` até o início do grupo seguinte (-1 = nenhum declarado)
+struct ObjGroup
+{
+    uint32_t firstTriangle;
+    int32_t material; // índice em ObjData::materials
+    int32_t object;   // índice em ObjData::objects
+};
+
+// Conteúdo de um .obj na ordem do arquivo. Cada 3 entradas de `corners` formam
+// um triângulo; faces com 4 ou mais vértices são trianguladas em leque.
+struct ObjData
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors; // vazio quando nenhum "v" traz cor
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjIndex> corners;
+    std::vector<std::string> materials;    // nomes de "usemtl", na ordem em que aparecem
+    std::vector<std::string> objects;      // nomes de "o" e "g", na ordem em que aparecem
+    std::vector<std::string> materialLibs; // arquivos de "mtllib", como escritos no OBJ
+    std::vector<ObjGroup> groups;          // vazio quando o arquivo não tem usemtl, o nem g
+};
+
+// Opções de carregamento do OBJ
+struct ObjLoadOptions
+{
+    unsigned threads = 0;   // 0 = um por núcleo, 1 = leitura serial
+    bool printStats = true; // imprime tamanho e tempo de carregamento
+
+    // Chamada na passada de contagem, assim que uma linha mtllib é lida e
+    // antes de os vértices serem convertidos, para que o .mtl e as texturas
+    // comecem a carregar em paralelo. Recebe o nome como escrito no OBJ; com
+    // várias threads pode ser chamada de qualquer uma delas.
+    std::function<void(const std::string& library)> onMaterialLibrary;
+};
+
+// Lê um .obj mapeado em memória. Uma passada de contagem dimensiona todos os
+// vetores de saída de uma vez; a segunda passada preenche sem realocações.
+// Aceita faces v, v/vt, v//vn e v/vt/vn, índices negativos, polígonos, a
+// coordenada homogênea "v x y z w" (w ignorado) e a extensão de cor por
+// vértice "v x y z r g b" (só com os seis números). As linhas usemtl, o, g e
+// mtllib são registradas em `groups`, `materials`, `objects` e `materialLibs`.
+//
+// Com mais de uma thread o arquivo é dividido em blocos alinhados em quebras de
+// linha; cada bloco é contado e lido em paralelo e uma soma de prefixos das
+// contagens define onde cada bloco escreve. O resultado é idêntico, byte a
+// byte, ao da leitura serial.
+bool parseOBJ(const char* path, ObjData& out, const ObjLoadOptions& options = ObjLoadOptions());
+
+// Normal (normalizada) do triângulo formado pelos cantos c[0], c[1] e c[2]
+glm::vec3 objFaceNormal(const ObjData& obj, const ObjIndex* c);
@@ -0,0 +1,110 @@
+#include "PixelUploadRing.h"
+
+#include <cstdint>
+
+using namespace std;
+
+PixelUploadRing::~PixelUploadRing()
+{
+    destroy();
+}
+
+void PixelUploadRing::create()
+{
+    destroy();
+    buffers.resize(bufferCount);
+    for (Buffer& buffer : buffers) {
+        glGenBuffers(1, &buffer.pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bufferBytes, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    current = 0;
+}
+
+void PixelUploadRing::destroy()
+{
+    for (Buffer& buffer : buffers) {
+        if (buffer.fence)
+            glDeleteSync(buffer.fence);
+        glDeleteBuffers(1, &buffer.pbo);
+    }
+    buffers.clear();
+}
+
+// Libera o buffer se a GPU já terminou de ler dele; nunca espera
+bool PixelUploadRing::reclaim(Buffer& buffer)
+{
+    if (!buffer.fence)
+        return true;
+    GLenum status = glClientWaitSync(buffer.fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+    glDeleteSync(buffer.fence);
+    buffer.fence = nullptr;
+    buffer.used = 0;
+    return true;
+}
+
+void* PixelUploadRing::begin(size_t bytes)
+{
+    if (buffers.empty() || bytes > bufferBytes)
+        return nullptr;
+
+    Buffer* buffer = &buffers[current];
+    if (!reclaim(*buffer))
+        return nullptr;
+    if (buffer->used + bytes > bufferBytes) {
+        // Todas as cópias deste buffer já foram pedidas: a fence marca o fim delas
+        buffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        current = (current + 1) % buffers.size();
+        buffer = &buffers[current];
+        if (!reclaim(*buffer))
+            return nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer->pbo);
+    void* pointer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, buffer->used, bytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!pointer) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return nullptr;
+    }
+    mappedOffset = buffer->used;
+    // Regiões seguintes começam alinhadas em 16 bytes
+    buffer->used = (buffer->used + bytes + 15) & ~(size_t)15;
+    return pointer;
+}
+
+void PixelUploadRing::endTexture(GLuint texture, GLint level, GLint y, GLsizei width, GLsizei rows, GLenum format,
+                                 GLint layer)
+{
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    const void* offset = reinterpret_cast<const void*>((uintptr_t)mappedOffset);
+    if (layer >= 0) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, layer, width, rows, 1, format, GL_UNSIGNED_BYTE, offset);
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, width, rows, format, GL_UNSIGNED_BYTE, offset);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void PixelUploadRing::endCompressedTexture(GLuint texture, GLint level, GLint y, GLsizei width, GLsizei rows,
+                                           GLenum internalFormat, size_t bytes, GLint layer)
+{
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    const void* offset = reinterpret_cast<const void*>((uintptr_t)mappedOffset);
+    if (layer >= 0) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, layer, width, rows, 1, internalFormat,
+                                  (GLsizei)bytes, offset);
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, y, width, rows, internalFormat, (GLsizei)bytes, offset);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
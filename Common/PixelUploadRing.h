@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Anel de buffers GL_PIXEL_UNPACK_BUFFER (PBOs) para enviar texturas sem
+// bloquear: cada faixa de linhas é escrita em uma região mapeada de um PBO e
+// glTexSubImage2D lê do offset dessa região, então a cópia para a textura
+// corre na GPU enquanto o quadro segue. Os buffers são preenchidos em
+// sequência; quando um enche recebe um glFenceSync e o próximo só é reusado
+// depois que a fence dele for sinalizada. Se todos ainda estiverem em voo,
+// begin() retorna nullptr em vez de esperar e quem chamou tenta no próximo
+// quadro. Deve ser usado na thread do contexto GL.
+//
+// O OpenGL 4.0 não tem mapeamento persistente (GL_ARB_buffer_storage): cada
+// região é mapeada com GL_MAP_UNSYNCHRONIZED_BIT, seguro porque a fence
+// garante que a GPU já terminou de ler o que estava ali.
+struct PixelUploadRing
+{
+    size_t bufferBytes = 4 << 20;
+    size_t bufferCount = 2; // dois buffers: um enchendo enquanto o outro é lido
+
+    PixelUploadRing() = default;
+    ~PixelUploadRing();
+
+    PixelUploadRing(const PixelUploadRing&) = delete;
+    PixelUploadRing& operator=(const PixelUploadRing&) = delete;
+
+    // Cria os PBOs com o tamanho e a quantidade configurados
+    void create();
+    void destroy();
+    bool created() const { return !buffers.empty(); }
+
+    // Reserva e mapeia `bytes` bytes para escrita; nullptr se não couber em
+    // um buffer ou se o próximo buffer ainda estiver em uso pela GPU
+    void* begin(size_t bytes);
+
+    // Desmapeia a região de begin() e copia dela as linhas [y, y + rows) do
+    // nível `level` de `texture`, vinculada em GL_TEXTURE_2D (ou, com `layer`
+    // >= 0, da camada `layer` de um GL_TEXTURE_2D_ARRAY). Deixa o PBO
+    // desvinculado (nenhum outro glTexImage2D lê dele por engano).
+    void endTexture(GLuint texture, GLint level, GLint y, GLsizei width, GLsizei rows, GLenum format,
+                    GLint layer = -1);
+
+    // Como endTexture, para `bytes` bytes de blocos BCn no formato interno
+    // `internalFormat`; `y` é múltiplo de 4 e `rows` vai até uma linha de
+    // blocos inteira ou até o fim do nível
+    void endCompressedTexture(GLuint texture, GLint level, GLint y, GLsizei width, GLsizei rows,
+                              GLenum internalFormat, size_t bytes, GLint layer = -1);
+
+private:
+    struct Buffer
+    {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        size_t used = 0;
+    };
+
+    bool reclaim(Buffer& buffer);
+
+    std::vector<Buffer> buffers;
+    size_t current = 0;
+    size_t mappedOffset = 0;
+};
@@ -0,0 +1,244 @@
+#include "TextureArrays.h"
+#include "UploadScheduler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+
+using namespace std;
+
+namespace {
+
+// Formato enviado ao GL: o do .ctex ou, se o driver não aceitar, RGBA8 descomprimido
+TextureFormat uploadFormat(TextureFormat format)
+{
+    return textureFormatSupported(format) ? format : TEXTURE_RGBA8;
+}
+
+// Envia todos os níveis de uma camada do array vinculado em GL_TEXTURE_2D_ARRAY
+void uploadLayer(const PreparedTexture& texture, TextureFormat format, GLint layer)
+{
+    vector<uint8_t> rgba;
+    for (size_t i = 0; i < texture.levels.size(); i++) {
+        const TextureLevel& level = texture.levels[i];
+        const uint8_t* pixels = texture.data + level.offset;
+        if (format == TEXTURE_RGBA8) {
+            if (texture.format != TEXTURE_RGBA8) {
+                rgba.resize((size_t)level.width * level.height * 4);
+                decompressLevel(texture.format, pixels, level.width, level.height, rgba.data());
+                pixels = rgba.data();
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)i, 0, 0, layer, level.width, level.height, 1, GL_RGBA,
+                            GL_UNSIGNED_BYTE, pixels);
+        }
+        else
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)i, 0, 0, layer, level.width, level.height, 1,
+                                      textureInternalFormat(format), (GLsizei)level.size, pixels);
+    }
+}
+
+// Uma textura e o lugar dela no conjunto
+struct LayerPlacement
+{
+    std::shared_ptr<PreparedTexture> texture;
+    int array;
+    int layer;
+};
+
+// Agrupa por formato enviado, tamanho e número de mips (na ordem dos
+// caminhos) e aloca todos os níveis de cada array, sem dados
+TextureArraySet allocateTextureArrays(const vector<shared_ptr<PreparedTexture>>& textures,
+                                      vector<LayerPlacement>& placements)
+{
+    typedef tuple<TextureFormat, uint32_t, uint32_t, size_t> GroupKey;
+    map<GroupKey, vector<shared_ptr<PreparedTexture>>> groups;
+    for (const shared_ptr<PreparedTexture>& texture : textures)
+        if (texture && !texture->levels.empty())
+            groups[GroupKey(uploadFormat(texture->format), texture->width, texture->height, texture->levels.size())]
+                .push_back(texture);
+
+    GLint maxLayers = 256;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+    GLint boundArray = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &boundArray);
+
+    TextureArraySet set;
+    for (auto& group : groups) {
+        const vector<shared_ptr<PreparedTexture>>& members = group.second;
+        for (size_t first = 0; first < members.size(); first += maxLayers) {
+            size_t count = min(members.size() - first, (size_t)maxLayers);
+            TextureArraySet::Array array;
+            array.format = get<0>(group.first);
+            array.width = get<1>(group.first);
+            array.height = get<2>(group.first);
+            array.levelCount = (uint32_t)get<3>(group.first);
+
+            glGenTextures(1, &array.texture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)array.levelCount - 1);
+
+            // Todos os níveis para todas as camadas, ainda sem dados
+            const vector<TextureLevel>& levels = members[first]->levels;
+            for (size_t i = 0; i < levels.size(); i++) {
+                const TextureLevel& level = levels[i];
+                if (array.format == TEXTURE_RGBA8)
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)i, GL_RGBA8, level.width, level.height, (GLsizei)count, 0,
+                                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                else
+                    glCompressedTexImage3D(
+                        GL_TEXTURE_2D_ARRAY, (GLint)i, textureInternalFormat(array.format), level.width, level.height,
+                        (GLsizei)count, 0,
+                        (GLsizei)(textureLevelBytes(array.format, level.width, level.height) * count), nullptr);
+            }
+            for (size_t layer = 0; layer < count; layer++) {
+                const shared_ptr<PreparedTexture>& texture = members[first + layer];
+                placements.push_back(LayerPlacement{ texture, (int)set.arrays.size(), (int)layer });
+                set.layers[texture->path] = make_pair((int)set.arrays.size(), (int)layer);
+                array.paths.push_back(texture->path);
+            }
+            set.arrays.push_back(std::move(array));
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, boundArray);
+
+    cout << "Texturas empacotadas: " << set.layers.size() << " em " << set.arrays.size() << " array(s)" << endl;
+    for (const TextureArraySet::Array& array : set.arrays)
+        cout << "  " << textureFormatName(array.format) << " " << array.width << "x" << array.height << ", "
+             << array.levelCount << " níveis: " << array.paths.size() << " camada(s)" << endl;
+    return set;
+}
+
+} // namespace
+
+bool TextureArraySet::find(const string& path, int& array, int& layer) const
+{
+    auto found = layers.find(path);
+    if (found == layers.end())
+        return false;
+    array = found->second.first;
+    layer = found->second.second;
+    return true;
+}
+
+bool TextureArraySet::replace(const PreparedTexture& texture)
+{
+    int array, layer;
+    if (!find(texture.path, array, layer))
+        return false;
+    const Array& target = arrays[array];
+    if (uploadFormat(texture.format) != target.format || texture.width != target.width ||
+        texture.height != target.height || texture.levels.size() != target.levelCount)
+        return false;
+
+    GLint boundArray = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &boundArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, target.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    uploadLayer(texture, target.format, layer);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, boundArray);
+    return true;
+}
+
+void TextureArraySet::destroy()
+{
+    for (Array& array : arrays)
+        glDeleteTextures(1, &array.texture);
+    arrays.clear();
+    layers.clear();
+}
+
+TextureArraySet packTextureArrays(const vector<shared_ptr<PreparedTexture>>& textures)
+{
+    vector<LayerPlacement> placements;
+    TextureArraySet set = allocateTextureArrays(textures, placements);
+
+    GLint boundArray = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &boundArray);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (const LayerPlacement& placement : placements) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, set.arrays[placement.array].texture);
+        uploadLayer(*placement.texture, set.arrays[placement.array].format, placement.layer);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, boundArray);
+    return set;
+}
+
+void packTextureArraysScheduled(UploadScheduler& scheduler, const vector<shared_ptr<PreparedTexture>>& textures,
+                                function<void(TextureArraySet&)> ready)
+{
+    vector<LayerPlacement> placements;
+    auto set = make_shared<TextureArraySet>(allocateTextureArrays(textures, placements));
+
+    for (const LayerPlacement& placement : placements) {
+        const TextureArraySet::Array& array = set->arrays[placement.array];
+        shared_ptr<PreparedTexture> texture = placement.texture;
+        if (texture->format == TEXTURE_RGBA8) {
+            for (size_t i = 0; i < texture->levels.size(); i++) {
+                const TextureLevel& level = texture->levels[i];
+                scheduler.enqueueTexture(array.texture, (GLint)i, level.width, level.height, GL_RGBA, 4,
+                                         texture->data + level.offset, texture, placement.layer);
+            }
+        }
+        else if (array.format == texture->format) {
+            // BCn em faixas de linhas de blocos, como o RGBA8
+            GLenum internalFormat = textureInternalFormat(array.format);
+            size_t blockBytes = textureLevelBytes(array.format, 4, 4);
+            for (size_t i = 0; i < texture->levels.size(); i++) {
+                const TextureLevel& level = texture->levels[i];
+                scheduler.enqueueCompressedTexture(array.texture, (GLint)i, level.width, level.height, internalFormat,
+                                                   blockBytes, texture->data + level.offset, texture, placement.layer);
+            }
+        }
+        else {
+            // BCn sem suporte no driver: descomprimido inteiro em um passo (a fila
+            // deixa o alinhamento em 1)
+            GLuint arrayTexture = array.texture;
+            TextureFormat format = array.format;
+            int layer = placement.layer;
+            scheduler.enqueueCallback([texture, arrayTexture, format, layer] {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, arrayTexture);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                uploadLayer(*texture, format, layer);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            });
+        }
+    }
+    scheduler.enqueueCallback([set, ready] { ready(*set); });
+}
+
+void assignTextureLayer(const TextureArraySet& set, Material& material, const string& fallbackPath)
+{
+    if (!set.find(material.diffuseMap.empty() ? fallbackPath : material.diffuseMap, material.diffuseArray,
+                  material.diffuseLayer)) {
+        material.diffuseArray = -1;
+        material.diffuseLayer = 0;
+    }
+}
+
+GLuint createPlaceholderTextureArray()
+{
+    const unsigned char pixels[4 * 4] = {
+        160, 160, 160, 255,  96, 96, 96, 255,
+         96,  96,  96, 255, 160, 160, 160, 255,
+    };
+
+    GLint boundArray = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &boundArray);
+
+    GLuint texID;
+    glGenTextures(1, &texID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texID);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, 2, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, boundArray);
+    return texID;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Material.h"
+#include "TextureContainer.h"
+
+struct UploadScheduler;
+
+// Texturas preparadas (.ctex) agrupadas em GL_TEXTURE_2D_ARRAY: as de mesmo
+// formato, tamanho e número de mips viram camadas de um mesmo array, então
+// objetos com texturas diferentes dividem um só vínculo e trocam apenas o
+// índice da camada, um uniform. Tamanhos diferentes ficam em arrays
+// diferentes (sem atlas: os mips de um atlas misturariam as bordas vizinhas).
+struct TextureArraySet
+{
+    struct Array
+    {
+        GLuint texture = 0;
+        TextureFormat format = TEXTURE_RGBA8; // formato enviado (RGBA8 se o driver não aceitar o BCn)
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levelCount = 0;
+        std::vector<std::string> paths; // caminho de cada camada
+    };
+
+    std::vector<Array> arrays;
+    std::map<std::string, std::pair<int, int>> layers; // caminho -> (array, camada)
+
+    // Array e camada de `path`; false se a textura não estiver no conjunto
+    bool find(const std::string& path, int& array, int& layer) const;
+
+    // Reenvia a camada de `texture.path` (textura recarregada). Retorna false
+    // se ela não estiver no conjunto ou se o formato, o tamanho ou os mips
+    // mudaram; nesse caso é preciso empacotar tudo de novo.
+    bool replace(const PreparedTexture& texture);
+
+    void destroy();
+};
+
+// Agrupa as texturas e cria os arrays com todos os níveis de todas as
+// camadas. Deve rodar em uma thread com contexto GL; não altera o vínculo de
+// GL_TEXTURE_2D_ARRAY. Imprime os grupos formados.
+TextureArraySet packTextureArrays(const std::vector<std::shared_ptr<PreparedTexture>>& textures);
+
+// O mesmo pela fila de envios: aloca os arrays agora e agenda as camadas nível
+// a nível, em faixas de linhas (de blocos, em BCn); só o BCn descomprimido por
+// falta de suporte vai uma camada por passo. `ready` recebe o conjunto quando a
+// última camada chegar à GPU
+void packTextureArraysScheduled(UploadScheduler& scheduler,
+                                const std::vector<std::shared_ptr<PreparedTexture>>& textures,
+                                std::function<void(TextureArraySet&)> ready);
+
+// Preenche diffuseArray/diffuseLayer de `material` com a posição do map_Kd
+// (ou de `fallbackPath`, se o material não tiver textura) em `set`
+void assignTextureLayer(const TextureArraySet& set, Material& material, const std::string& fallbackPath);
+
+// Array de uma camada com um xadrez 2x2 cinza, para os shaders com
+// sampler2DArray enquanto as texturas não chegam
+GLuint createPlaceholderTextureArray();
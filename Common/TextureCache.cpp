@@ -0,0 +1,88 @@
+#include "TextureCache.h"
+#include "AssetLoader.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+TextureCache::TextureCache(AssetLoader& loader, const TextureBuildOptions& options) : loader(loader), options(options) {}
+
+void TextureCache::request(const string& path, function<void(shared_ptr<PreparedTexture>)> ready)
+{
+    shared_ptr<Entry> entry;
+    shared_ptr<PreparedTexture> cached;
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        requests++;
+        shared_ptr<Entry>& slot = entries[path];
+        if (!slot)
+            slot = make_shared<Entry>();
+        entry = slot;
+        if (entry->texture)
+            cached = entry->texture;
+        else {
+            entry->waiting.push_back(std::move(ready));
+            if (entry->preparing)
+                return;
+            entry->preparing = true;
+            prepares++;
+        }
+    }
+
+    // Já preparada: só passa pela fila para `ready` rodar em poll()
+    if (cached) {
+        loader.submit([] {}, [cached, ready] { ready(cached); });
+        return;
+    }
+
+    auto texture = make_shared<PreparedTexture>();
+    loader.submit(
+        [this, texture, path] {
+            auto start = chrono::steady_clock::now();
+            bool prepared = prepareTexture(path, *texture, options);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+            lock_guard<mutex> lock(cacheMutex);
+            ThreadStats& stats = threadStats[this_thread::get_id()];
+            stats.ms += ms;
+            if (prepared) {
+                stats.textures++;
+                stats.bytes += texture->uncompressedBytes();
+            }
+        },
+        [this, entry, texture] {
+            vector<function<void(shared_ptr<PreparedTexture>)>> waiting;
+            {
+                lock_guard<mutex> lock(cacheMutex);
+                entry->preparing = false;
+                if (!texture->levels.empty())
+                    entry->texture = texture;
+                waiting.swap(entry->waiting);
+            }
+            // Falha (já registrada por prepareTexture): todos recebem nullptr
+            shared_ptr<PreparedTexture> result = !texture->levels.empty() ? texture : nullptr;
+            for (auto& ready : waiting)
+                ready(result);
+        });
+}
+
+void TextureCache::invalidate(const string& path)
+{
+    lock_guard<mutex> lock(cacheMutex);
+    entries.erase(path);
+}
+
+void TextureCache::printStats() const
+{
+    lock_guard<mutex> lock(cacheMutex);
+    cout << "Texturas: " << requests << " pedidos, " << prepares << " preparações ("
+         << requests - prepares << " reaproveitadas)" << endl;
+    int index = 0;
+    for (const auto& entry : threadStats) {
+        const ThreadStats& stats = entry.second;
+        double mb = stats.bytes / (1024.0 * 1024.0);
+        cout << "  thread " << index++ << ": " << stats.textures << " texturas, " << mb << " MB em " << stats.ms
+             << " ms (" << (stats.ms > 0.0 ? mb / (stats.ms / 1000.0) : 0.0) << " MB/s)" << endl;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TextureContainer.h"
+
+struct AssetLoader;
+
+// Texturas preparadas (prepareTexture: .ctex mapeado ou imagem convertida)
+// por caminho, compartilhadas entre quem pedir o mesmo arquivo. A preparação
+// roda nas threads do AssetLoader, várias texturas ao mesmo tempo, com as
+// `options` do cache; pedidos do mesmo caminho feitos enquanto ela roda
+// esperam o mesmo resultado em vez de ler de novo. As texturas ficam
+// guardadas até invalidate().
+struct TextureCache
+{
+    explicit TextureCache(AssetLoader& loader, const TextureBuildOptions& options = TextureBuildOptions());
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Entrega a textura de `path` a `ready` dentro de poll() do loader (nullptr
+    // se a preparação falhar; o próximo pedido tenta de novo). Pode ser chamada
+    // de qualquer thread, inclusive de dentro de um trabalho.
+    void request(const std::string& path, std::function<void(std::shared_ptr<PreparedTexture>)> ready);
+
+    // Esquece a textura de `path` (arquivo alterado); o próximo pedido relê.
+    // Quem já esperava uma preparação em andamento ainda recebe a antiga.
+    void invalidate(const std::string& path);
+
+    // Pedidos, preparações e vazão de cada thread de trabalho
+    void printStats() const;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<PreparedTexture> texture;
+        bool preparing = false;
+        std::vector<std::function<void(std::shared_ptr<PreparedTexture>)>> waiting;
+    };
+
+    struct ThreadStats
+    {
+        size_t textures = 0;
+        size_t bytes = 0; // todos os níveis em RGBA8, como na vazão de prepareTexture
+        double ms = 0.0;
+    };
+
+    AssetLoader& loader;
+    TextureBuildOptions options;
+
+    mutable std::mutex cacheMutex;
+    std::map<std::string, std::shared_ptr<Entry>> entries;
+    std::map<std::thread::id, ThreadStats> threadStats;
+    size_t requests = 0;
+    size_t prepares = 0;
+};
@@ -0,0 +1,380 @@
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEXTURE_COMPRESSION_SSE2 1
+#endif
+
+using namespace std;
+
+namespace {
+
+// Abaixo deste número de blocos em um nível o custo de criar threads supera o ganho
+const size_t kMinParallelBlocks = 4096;
+
+// Executa job(i) para cada faixa, uma faixa por thread
+template <typename Job>
+void runBands(size_t bands, Job job)
+{
+    vector<thread> workers;
+    workers.reserve(bands - 1);
+    for (size_t i = 1; i < bands; i++)
+        workers.emplace_back(job, i);
+    job(0);
+    for (thread& t : workers)
+        t.join();
+}
+
+// Copia o bloco 4x4 em (bx, by) para 16 pixels RGBA contíguos, repetindo a
+// última linha e a última coluna quando o nível não é múltiplo de 4
+void fetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t block[64])
+{
+    for (uint32_t y = 0; y < 4; y++) {
+        uint32_t sy = min(by * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; x++) {
+            uint32_t sx = min(bx * 4 + x, width - 1);
+            memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+        }
+    }
+}
+
+inline uint16_t packRgb565(const uint8_t c[4])
+{
+    return (uint16_t)(((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3));
+}
+
+inline void unpackRgb565(uint16_t c, int rgb[3])
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Cor em BC1: extremos pela caixa envolvente dos 16 pixels, encolhida 1/16 de
+// cada lado para aproximar os extremos da média, e índices pela projeção de
+// cada pixel na reta entre os extremos (sempre no modo de 4 cores)
+void encodeColorBlock(const uint8_t block[64], uint8_t out[8])
+{
+    uint8_t minColor[4], maxColor[4];
+#ifdef TEXTURE_COMPRESSION_SSE2
+    const __m128i* pixels = reinterpret_cast<const __m128i*>(block);
+    __m128i p0 = _mm_loadu_si128(pixels), p1 = _mm_loadu_si128(pixels + 1);
+    __m128i p2 = _mm_loadu_si128(pixels + 2), p3 = _mm_loadu_si128(pixels + 3);
+    __m128i lo = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+    __m128i hi = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+    lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+    lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+    hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+    hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t lo32 = (uint32_t)_mm_cvtsi128_si32(lo), hi32 = (uint32_t)_mm_cvtsi128_si32(hi);
+    memcpy(minColor, &lo32, 4);
+    memcpy(maxColor, &hi32, 4);
+#else
+    memcpy(minColor, block, 4);
+    memcpy(maxColor, block, 4);
+    for (int i = 1; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            minColor[c] = min(minColor[c], block[i * 4 + c]);
+            maxColor[c] = max(maxColor[c], block[i * 4 + c]);
+        }
+    }
+#endif
+    for (int c = 0; c < 3; c++) {
+        int inset = (maxColor[c] - minColor[c]) >> 4;
+        minColor[c] = (uint8_t)(minColor[c] + inset);
+        maxColor[c] = (uint8_t)(maxColor[c] - inset);
+    }
+
+    // color0 > color1 seleciona o modo de 4 cores; iguais, todos os índices 0
+    uint16_t color0 = packRgb565(maxColor), color1 = packRgb565(minColor);
+    if (color0 < color1)
+        swap(color0, color1);
+    int end0[3], end1[3];
+    unpackRgb565(color0, end0);
+    unpackRgb565(color1, end1);
+
+    uint32_t indices = 0;
+    int dir[3] = { end0[0] - end1[0], end0[1] - end1[1], end0[2] - end1[2] };
+    int length2 = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+    if (color0 != color1 && length2 > 0) {
+        // Passo 0..3 ao longo da reta (0 = color1, 3 = color0) -> índice BC1
+        const uint32_t stepToIndex[4] = { 1, 3, 2, 0 };
+        int steps[16];
+#ifdef TEXTURE_COMPRESSION_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i base = _mm_setr_epi16((short)end1[0], (short)end1[1], (short)end1[2], 0, (short)end1[0],
+                                            (short)end1[1], (short)end1[2], 0);
+        const __m128i axis = _mm_setr_epi16((short)dir[0], (short)dir[1], (short)dir[2], 0, (short)dir[0],
+                                            (short)dir[1], (short)dir[2], 0);
+        const __m128 scale = _mm_set1_ps(3.0f / length2);
+        const __m128i maxStep = _mm_set1_epi16(3);
+        for (int q = 0; q < 4; q++) {
+            __m128i px = _mm_loadu_si128(pixels + q);
+            // Produto escalar de 4 pixels: madd soma (r, g) e (b, a) de cada um
+            __m128i a = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(px, zero), base), axis);
+            __m128i b = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(px, zero), base), axis);
+            __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1));
+            __m128i dots = _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+            __m128i step = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(dots), scale));
+            step = _mm_packs_epi32(step, step);
+            step = _mm_min_epi16(_mm_max_epi16(step, zero), maxStep);
+            step = _mm_unpacklo_epi16(step, zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(steps + q * 4), step);
+        }
+#else
+        for (int i = 0; i < 16; i++) {
+            const uint8_t* p = block + i * 4;
+            int dot = (p[0] - end1[0]) * dir[0] + (p[1] - end1[1]) * dir[1] + (p[2] - end1[2]) * dir[2];
+            // Mesmo arredondamento do caminho SSE2 (para o par mais próximo)
+            steps[i] = clamp((int)lrintf((float)dot * (3.0f / length2)), 0, 3);
+        }
+#endif
+        for (int i = 0; i < 16; i++)
+            indices |= stepToIndex[steps[i]] << (i * 2);
+    }
+
+    out[0] = (uint8_t)(color0 & 0xFF);
+    out[1] = (uint8_t)(color0 >> 8);
+    out[2] = (uint8_t)(color1 & 0xFF);
+    out[3] = (uint8_t)(color1 >> 8);
+    memcpy(out + 4, &indices, 4);
+}
+
+// Um canal em BC4 (alfa do BC3, R e G do BC5): extremos = mínimo e máximo,
+// modo de 8 valores, índice de 3 bits pelo valor interpolado mais próximo
+void encodeChannelBlock(const uint8_t block[64], int channel, uint8_t out[8])
+{
+    int lo = block[channel], hi = block[channel];
+    for (int i = 1; i < 16; i++) {
+        lo = min(lo, (int)block[i * 4 + channel]);
+        hi = max(hi, (int)block[i * 4 + channel]);
+    }
+
+    uint64_t bits = 0;
+    if (hi > lo) {
+        int range = hi - lo;
+        for (int i = 0; i < 16; i++) {
+            // Passo 0..7 de `lo` até `hi`; o índice 0 é hi, o 1 é lo e 2..7 vão de hi para lo
+            int step = ((block[i * 4 + channel] - lo) * 7 + range / 2) / range;
+            uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+            bits |= index << (i * 3);
+        }
+    }
+
+    out[0] = (uint8_t)hi;
+    out[1] = (uint8_t)lo;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (uint8_t)(bits >> (i * 8));
+}
+
+void encodeBlock(TextureFormat format, const uint8_t block[64], uint8_t* out)
+{
+    switch (format) {
+    case TEXTURE_RGBA8:
+        memcpy(out, block, 64);
+        break;
+    case TEXTURE_BC1:
+        encodeColorBlock(block, out);
+        break;
+    case TEXTURE_BC3:
+        encodeChannelBlock(block, 3, out);
+        encodeColorBlock(block, out + 8);
+        break;
+    case TEXTURE_BC5:
+        encodeChannelBlock(block, 0, out);
+        encodeChannelBlock(block, 1, out + 8);
+        break;
+    }
+}
+
+void decodeColorBlock(const uint8_t in[8], uint8_t out[64], bool alwaysFourColors)
+{
+    uint16_t color0 = (uint16_t)(in[0] | (in[1] << 8));
+    uint16_t color1 = (uint16_t)(in[2] | (in[3] << 8));
+    int end0[3], end1[3];
+    unpackRgb565(color0, end0);
+    unpackRgb565(color1, end1);
+
+    uint8_t palette[4][4];
+    for (int c = 0; c < 3; c++) {
+        palette[0][c] = (uint8_t)end0[c];
+        palette[1][c] = (uint8_t)end1[c];
+        if (color0 > color1 || alwaysFourColors) {
+            palette[2][c] = (uint8_t)((2 * end0[c] + end1[c]) / 3);
+            palette[3][c] = (uint8_t)((end0[c] + 2 * end1[c]) / 3);
+        }
+        else {
+            palette[2][c] = (uint8_t)((end0[c] + end1[c]) / 2);
+            palette[3][c] = 0;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = color0 > color1 || alwaysFourColors ? 255 : 0;
+
+    uint32_t indices;
+    memcpy(&indices, in + 4, 4);
+    for (int i = 0; i < 16; i++)
+        memcpy(out + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+}
+
+void decodeChannelBlock(const uint8_t in[8], int channel, uint8_t out[64])
+{
+    int a0 = in[0], a1 = in[1];
+    int palette[8] = { a0, a1 };
+    if (a0 > a1) {
+        for (int i = 2; i < 8; i++)
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+    else {
+        for (int i = 2; i < 6; i++)
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; i++)
+        bits |= (uint64_t)in[2 + i] << (i * 8);
+    for (int i = 0; i < 16; i++)
+        out[i * 4 + channel] = (uint8_t)palette[(bits >> (i * 3)) & 7];
+}
+
+void decodeBlock(TextureFormat format, const uint8_t* in, uint8_t block[64])
+{
+    switch (format) {
+    case TEXTURE_RGBA8:
+        memcpy(block, in, 64);
+        break;
+    case TEXTURE_BC1:
+        decodeColorBlock(in, block, false);
+        break;
+    case TEXTURE_BC3:
+        decodeColorBlock(in + 8, block, true);
+        decodeChannelBlock(in, 3, block);
+        break;
+    case TEXTURE_BC5:
+        for (int i = 0; i < 16; i++) {
+            block[i * 4 + 2] = 0;
+            block[i * 4 + 3] = 255;
+        }
+        decodeChannelBlock(in, 0, block);
+        decodeChannelBlock(in + 8, 1, block);
+        break;
+    }
+}
+
+// Cada thread comprime uma faixa de linhas de blocos
+void compressLevel(TextureFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out,
+                   unsigned threads)
+{
+    size_t blockBytes = textureBlockBytes(format);
+    uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t bands = (size_t)blocksX * blocksY < kMinParallelBlocks ? 1 : min<size_t>(threads, blocksY);
+    runBands(bands, [&](size_t band) {
+        uint8_t block[64];
+        uint32_t first = (uint32_t)(blocksY * band / bands), last = (uint32_t)(blocksY * (band + 1) / bands);
+        for (uint32_t by = first; by < last; by++) {
+            for (uint32_t bx = 0; bx < blocksX; bx++) {
+                fetchBlock(rgba, width, height, bx, by, block);
+                encodeBlock(format, block, out + ((size_t)by * blocksX + bx) * blockBytes);
+            }
+        }
+    });
+}
+
+} // namespace
+
+const char* textureFormatName(TextureFormat format)
+{
+    switch (format) {
+    case TEXTURE_RGBA8:
+        return "RGBA8";
+    case TEXTURE_BC1:
+        return "BC1";
+    case TEXTURE_BC3:
+        return "BC3";
+    case TEXTURE_BC5:
+        return "BC5";
+    }
+    return "?";
+}
+
+size_t textureBlockBytes(TextureFormat format)
+{
+    return format == TEXTURE_RGBA8 ? 64 : format == TEXTURE_BC1 ? 8 : 16;
+}
+
+size_t textureLevelBytes(TextureFormat format, uint32_t width, uint32_t height)
+{
+    if (format == TEXTURE_RGBA8)
+        return (size_t)width * height * 4;
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * textureBlockBytes(format);
+}
+
+TextureFormat chooseTextureFormat(const TextureImage& rgba, bool normalMap)
+{
+    if (normalMap)
+        return TEXTURE_BC5;
+    if (rgba.channels == 4) {
+        size_t pixels = (size_t)rgba.width * rgba.height;
+        for (size_t i = 0; i < pixels; i++)
+            if (rgba.data[i * 4 + 3] != 255)
+                return TEXTURE_BC3;
+    }
+    return TEXTURE_BC1;
+}
+
+void compressTexture(const TextureImage& rgba, TextureFormat format, vector<TextureLevel>& levels,
+                     vector<uint8_t>& data, const MipOptions& mips)
+{
+    levels.clear();
+    data.clear();
+    if (rgba.channels != 4 || !rgba.data)
+        return;
+
+    // Em RGBA8 a própria cadeia de mips já é o resultado
+    if (format == TEXTURE_RGBA8) {
+        generateMipChain(rgba.data, (uint32_t)rgba.width, (uint32_t)rgba.height, mips, levels, data);
+        return;
+    }
+
+    vector<TextureLevel> mipLevels;
+    vector<uint8_t> mipData;
+    generateMipChain(rgba.data, (uint32_t)rgba.width, (uint32_t)rgba.height, mips, mipLevels, mipData);
+
+    unsigned threadCount = mips.threads ? mips.threads : max(1u, thread::hardware_concurrency());
+    for (const TextureLevel& mip : mipLevels) {
+        TextureLevel level{ mip.width, mip.height, data.size(), textureLevelBytes(format, mip.width, mip.height) };
+        data.resize(data.size() + level.size);
+        compressLevel(format, mipData.data() + mip.offset, mip.width, mip.height, data.data() + level.offset,
+                      threadCount);
+        levels.push_back(level);
+    }
+}
+
+void decompressLevel(TextureFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba)
+{
+    if (format == TEXTURE_RGBA8) {
+        memcpy(rgba, blocks, textureLevelBytes(format, width, height));
+        return;
+    }
+    size_t blockBytes = textureBlockBytes(format);
+    uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    uint8_t block[64];
+    for (uint32_t by = 0; by < blocksY; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++) {
+            decodeBlock(format, blocks + ((size_t)by * blocksX + bx) * blockBytes, block);
+            for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+                uint32_t columns = min(4u, width - bx * 4);
+                memcpy(rgba + ((size_t)(by * 4 + y) * width + bx * 4) * 4, block + y * 16, columns * 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MipGenerator.h"
+#include "TextureImage.h"
+
+// Formatos de textura: RGBA8 sem compressão ou comprimidos em blocos de 4x4 pixels
+enum TextureFormat : uint32_t
+{
+    TEXTURE_RGBA8 = 0, // 4 bytes por pixel, sem perda
+    TEXTURE_BC1 = 1,   // DXT1: RGB opaco, 8 bytes por bloco (0,5 byte por pixel)
+    TEXTURE_BC3 = 2,   // DXT5: RGBA, 16 bytes por bloco (alfa em BC4 + cor em BC1)
+    TEXTURE_BC5 = 3,   // RGTC2: dois canais (R, G), para mapas de normais; 16 bytes por bloco
+};
+
+const char* textureFormatName(TextureFormat format);
+
+// Bytes de um bloco 4x4 e de um nível w x h (nos formatos BCn, blocos
+// incompletos nas bordas contam inteiros)
+size_t textureBlockBytes(TextureFormat format);
+size_t textureLevelBytes(TextureFormat format, uint32_t width, uint32_t height);
+
+// BC1 se todos os pixels forem opacos, senão BC3; `normalMap` escolhe BC5
+TextureFormat chooseTextureFormat(const TextureImage& rgba, bool normalMap = false);
+
+// Gera a cadeia de mips com generateMipChain (filtro e espaço de cor de
+// `mips`) e comprime todos os níveis em `format` (TEXTURE_RGBA8 guarda os
+// pixels como estão), um após o outro em `data`. `rgba` precisa ter 4 canais.
+// As linhas de blocos de cada nível são divididas entre `mips.threads`
+// threads (0 = número de núcleos); o cálculo de cada bloco usa SSE2 quando
+// disponível.
+void compressTexture(const TextureImage& rgba, TextureFormat format, std::vector<TextureLevel>& levels,
+                     std::vector<uint8_t>& data, const MipOptions& mips = MipOptions());
+
+// Descomprime um nível para RGBA8 (w * h * 4 bytes em `rgba`); usado quando
+// o driver não aceita o formato e para medir o erro da compressão
+void decompressLevel(TextureFormat format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba);
@@ -0,0 +1,269 @@
+#include "TextureContainer.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static_assert(sizeof(TextureContainerHeader) == 64, "TextureContainerHeader não pode ter padding");
+static_assert(sizeof(TextureLevel) == 24, "TextureLevel não pode ter padding");
+
+// Formatos S3TC: extensão, ausente do glad gerado só com o núcleo
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace {
+
+const char TEXTURE_CONTAINER_MAGIC[4] = { 'C', 'G', 'T', 'X' };
+
+uint64_t alignTo16(uint64_t offset)
+{
+    return (offset + 15) & ~uint64_t(15);
+}
+
+bool hasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const GLubyte* extension = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension && strcmp(reinterpret_cast<const char*>(extension), name) == 0)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+size_t PreparedTexture::storedBytes() const
+{
+    size_t total = 0;
+    for (const TextureLevel& level : levels)
+        total += level.size;
+    return total;
+}
+
+size_t PreparedTexture::uncompressedBytes() const
+{
+    size_t total = 0;
+    for (const TextureLevel& level : levels)
+        total += (size_t)level.width * level.height * 4;
+    return total;
+}
+
+string textureContainerPath(const string& sourcePath)
+{
+    return sourcePath + ".ctex";
+}
+
+bool hashSourceFile(const string& path, uint64_t& hash)
+{
+    MappedFile file;
+    if (!file.open(path.c_str()))
+        return false;
+    hash = hashBytes(file.data(), file.size());
+    return true;
+}
+
+bool openTextureContainer(const string& containerPath, const string& sourcePath, const SourceStamp& stamp,
+                          PreparedTexture& out)
+{
+    if (!out.file.open(containerPath.c_str()) || out.file.size() < sizeof(TextureContainerHeader))
+        return false;
+
+    const char* base = out.file.data();
+    const TextureContainerHeader* h = reinterpret_cast<const TextureContainerHeader*>(base);
+    if (memcmp(h->magic, TEXTURE_CONTAINER_MAGIC, 4) != 0 || h->version != TEXTURE_CONTAINER_VERSION)
+        return false;
+    if (h->format > TEXTURE_BC5 || h->mipFilter > MIP_FILTER_KAISER || h->levelCount == 0 ||
+        h->sourceSize != stamp.size)
+        return false;
+    bool restamp = h->sourceTime != stamp.time;
+    if (restamp) {
+        uint64_t hash;
+        if (!hashSourceFile(sourcePath, hash) || hash != h->sourceHash)
+            return false;
+    }
+
+    uint64_t size = out.file.size();
+    if (h->levelOffset + (uint64_t)h->levelCount * sizeof(TextureLevel) > size)
+        return false;
+
+    TextureFormat format = (TextureFormat)h->format;
+    const TextureLevel* levels = reinterpret_cast<const TextureLevel*>(base + h->levelOffset);
+    for (uint32_t i = 0; i < h->levelCount; i++) {
+        if (levels[i].size != textureLevelBytes(format, levels[i].width, levels[i].height) ||
+            levels[i].offset + levels[i].size > size)
+            return false;
+    }
+
+    out.format = format;
+    out.mipFilter = (MipFilter)h->mipFilter;
+    out.mipSrgb = h->mipSrgb != 0;
+    out.width = h->width;
+    out.height = h->height;
+    out.levels.assign(levels, levels + h->levelCount);
+    out.data = reinterpret_cast<const uint8_t*>(base);
+
+    // Conteúdo igual com outra data: grava a data nova no cabeçalho para o hash
+    // não ser refeito a cada abertura. Se não der (arquivo em uso), fica para a próxima.
+    if (restamp) {
+        fstream file(containerPath, ios::binary | ios::in | ios::out);
+        if (file.is_open()) {
+            file.seekp(offsetof(TextureContainerHeader, sourceTime));
+            file.write(reinterpret_cast<const char*>(&stamp.time), sizeof(stamp.time));
+        }
+    }
+    return true;
+}
+
+bool writeTextureContainer(const string& containerPath, const SourceStamp& stamp, uint64_t sourceHash,
+                           const PreparedTexture& texture)
+{
+    TextureContainerHeader h = {};
+    memcpy(h.magic, TEXTURE_CONTAINER_MAGIC, 4);
+    h.version = TEXTURE_CONTAINER_VERSION;
+    h.sourceSize = stamp.size;
+    h.sourceTime = stamp.time;
+    h.sourceHash = sourceHash;
+    h.format = texture.format;
+    h.width = texture.width;
+    h.height = texture.height;
+    h.levelCount = (uint32_t)texture.levels.size();
+    h.levelOffset = alignTo16(sizeof(TextureContainerHeader));
+    h.mipFilter = texture.mipFilter;
+    h.mipSrgb = texture.mipSrgb ? 1 : 0;
+
+    // No arquivo os offsets contam do início; os níveis ficam em sequência
+    uint64_t dataOffset = alignTo16(h.levelOffset + (uint64_t)h.levelCount * sizeof(TextureLevel));
+    vector<TextureLevel> levels = texture.levels;
+    for (size_t i = 0; i < levels.size(); i++) {
+        levels[i].offset = dataOffset;
+        dataOffset = alignTo16(dataOffset + levels[i].size);
+    }
+
+    string tmpPath = uniqueTempPath(containerPath);
+    ofstream out(tmpPath, ios::binary | ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    const char zeros[16] = {};
+    auto padTo = [&](uint64_t offset) {
+        uint64_t pos = (uint64_t)out.tellp();
+        if (offset > pos)
+            out.write(zeros, offset - pos);
+    };
+
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    padTo(h.levelOffset);
+    out.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(TextureLevel));
+    for (size_t i = 0; i < levels.size(); i++) {
+        padTo(levels[i].offset);
+        out.write(reinterpret_cast<const char*>(texture.data + texture.levels[i].offset), levels[i].size);
+    }
+
+    out.close();
+    if (!out) {
+        fs::remove(tmpPath);
+        return false;
+    }
+
+    error_code ec;
+    fs::rename(tmpPath, containerPath, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool prepareTexture(const string& path, PreparedTexture& out, const TextureBuildOptions& options)
+{
+    auto start = chrono::steady_clock::now();
+    out.path = path;
+
+    SourceStamp stamp;
+    if (!readSourceStamp(path.c_str(), stamp)) {
+        cout << "Falha ao carregar textura: " << path << endl;
+        return false;
+    }
+
+    // Mapas de normais guardam vetores, não cor: nada de sRGB
+    MipOptions mips = options.mips;
+    mips.srgb = mips.srgb && !options.normalMap;
+
+    string containerPath = textureContainerPath(path);
+    if (options.container && openTextureContainer(containerPath, path, stamp, out)) {
+        bool wanted = options.compress ? out.format != TEXTURE_RGBA8 && (out.format == TEXTURE_BC5) == options.normalMap
+                                       : out.format == TEXTURE_RGBA8;
+        if (wanted && out.mipFilter == mips.filter && out.mipSrgb == mips.srgb) {
+            cout << "Textura do cache: " << containerPath << " (" << textureFormatName(out.format) << ", "
+                 << out.width << "x" << out.height << ", " << out.levels.size() << " níveis, "
+                 << out.storedBytes() / 1024 << " KB) em "
+                 << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+            return true;
+        }
+    }
+    out.file.close();
+    out.levels.clear();
+
+    uint64_t sourceHash = 0;
+    TextureImage image;
+    if ((options.container && !hashSourceFile(path, sourceHash)) || !decodeTexture(path, image, true, 4))
+        return false;
+
+    auto encodeStart = chrono::steady_clock::now();
+    out.format = options.compress ? chooseTextureFormat(image, options.normalMap) : TEXTURE_RGBA8;
+    out.width = (uint32_t)image.width;
+    out.height = (uint32_t)image.height;
+    out.mipFilter = mips.filter;
+    out.mipSrgb = mips.srgb;
+    compressTexture(image, out.format, out.levels, out.encoded, mips);
+    out.data = out.encoded.data();
+    double encodeMs = chrono::duration<double, milli>(chrono::steady_clock::now() - encodeStart).count();
+
+    if (options.container && !writeTextureContainer(containerPath, stamp, sourceHash, out))
+        cout << "Não foi possível gravar o cache de textura: " << containerPath << endl;
+
+    // A vazão conta os pixels RGBA8 de todos os níveis que passaram pelo codificador
+    double kb = out.storedBytes() / 1024.0, rgbaKb = out.uncompressedBytes() / 1024.0;
+    cout << "Textura convertida: " << path << " (" << textureFormatName(out.format) << ", " << out.levels.size()
+         << " níveis, filtro " << mipFilterName(mips.filter) << (mips.srgb ? " em espaço linear" : "") << "): " << kb
+         << " KB";
+    if (out.format != TEXTURE_RGBA8)
+        cout << " em vez de " << rgbaKb << " KB em RGBA8 (" << 100.0 * (1.0 - kb / rgbaKb) << "% menos)";
+    cout << " em " << encodeMs << " ms (" << rgbaKb / 1024.0 / (encodeMs / 1000.0) << " MB/s)" << endl;
+    return true;
+}
+
+GLenum textureInternalFormat(TextureFormat format)
+{
+    switch (format) {
+    case TEXTURE_RGBA8:
+        return GL_RGBA8;
+    case TEXTURE_BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TEXTURE_BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TEXTURE_BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    }
+    return 0;
+}
+
+bool textureFormatSupported(TextureFormat format)
+{
+    if (format == TEXTURE_RGBA8 || format == TEXTURE_BC5)
+        return true;
+    static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+    return s3tc;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "TextureCompression.h"
+
+// Textura pré-processada (.ctex), gravada ao lado da imagem de origem: todos
+// os níveis de mip já gerados, em RGBA8 ou comprimidos em BCn, na ordem de
+// envio. As cargas seguintes mapeiam o arquivo e passam cada nível direto
+// para glTexImage2D/glCompressedTexImage2D, sem decodificar nada.
+//
+// Layout (little-endian): TextureContainerHeader | níveis (TextureLevel) |
+// dados, com cada bloco alinhado em 16 bytes; os offsets dos níveis contam do
+// início do arquivo.
+
+const uint32_t TEXTURE_CONTAINER_VERSION = 3;
+
+struct TextureContainerHeader
+{
+    char magic[4];       // "CGTX"
+    uint32_t version;    // TEXTURE_CONTAINER_VERSION
+    uint64_t sourceSize; // tamanho da imagem de origem
+    int64_t sourceTime;  // data de modificação da imagem de origem
+    uint64_t sourceHash; // hashBytes do conteúdo da imagem de origem
+    uint32_t format;     // TextureFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint64_t levelOffset;
+    uint32_t mipFilter;  // MipFilter usado na geração dos mips
+    uint32_t mipSrgb;    // 1 = mips filtrados em espaço linear (RGB em sRGB)
+};
+
+// Como gerar o .ctex quando ele não existe ou está desatualizado
+struct TextureBuildOptions
+{
+    bool compress = true;   // BC1/BC3 pela presença de alfa (BC5 se normalMap); false = RGBA8
+    bool normalMap = false; // normais não são cor: mips filtrados sem conversão sRGB
+    MipOptions mips;        // filtro dos mips e threads do gerador e do codificador
+    bool container = true;  // false = converte sempre, sem ler nem gravar o .ctex (medições)
+};
+
+// Textura pronta para o envio: aponta para o .ctex mapeado ou para os dados
+// recém-gerados em `encoded`
+struct PreparedTexture
+{
+    std::string path;
+    MappedFile file;
+    std::vector<uint8_t> encoded;
+
+    TextureFormat format = TEXTURE_RGBA8;
+    MipFilter mipFilter = MIP_FILTER_BOX;
+    bool mipSrgb = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<TextureLevel> levels;
+    const uint8_t* data = nullptr; // base dos offsets de `levels`
+
+    // Soma dos níveis no formato guardado e o que os mesmos níveis ocupariam em RGBA8
+    size_t storedBytes() const;
+    size_t uncompressedBytes() const;
+};
+
+// Caminho do .ctex de uma imagem ("pixelWall.png" -> "pixelWall.png.ctex")
+std::string textureContainerPath(const std::string& sourcePath);
+
+// Hash do conteúdo de um arquivo (mapeado), para conferir a origem do .ctex
+bool hashSourceFile(const std::string& path, uint64_t& hash);
+
+// Abre o .ctex e confere versão e tamanho dos níveis. A origem vale se o
+// tamanho e a data baterem; com a data diferente (cópia, checkout) o conteúdo
+// de `sourcePath` é comparado pelo hash e, se bater, a data nova é gravada no
+// cabeçalho para o hash ser pago uma vez só.
+bool openTextureContainer(const std::string& containerPath, const std::string& sourcePath, const SourceStamp& stamp,
+                          PreparedTexture& out);
+
+// Grava em um arquivo temporário e renomeia, para nunca deixar um .ctex parcial
+bool writeTextureContainer(const std::string& containerPath, const SourceStamp& stamp, uint64_t sourceHash,
+                           const PreparedTexture& texture);
+
+// Usa o .ctex se estiver em dia, no formato e com os mips pedidos; senão decodifica a
+// imagem em RGBA, gera os mips, comprime conforme `options` e grava o .ctex.
+// Imprime o formato, a memória economizada e a vazão. Não usa OpenGL; pode
+// rodar em uma thread de trabalho.
+bool prepareTexture(const std::string& path, PreparedTexture& out,
+                    const TextureBuildOptions& options = TextureBuildOptions());
+
+// Formato interno do OpenGL (GL_RGBA8, GL_COMPRESSED_*) de cada TextureFormat
+GLenum textureInternalFormat(TextureFormat format);
+
+// O driver aceita o formato? BC1/BC3 exigem GL_EXT_texture_compression_s3tc;
+// BC5 (RGTC) faz parte do OpenGL 3.0. Consultar no contexto GL.
+bool textureFormatSupported(TextureFormat format);
@@ -0,0 +1,36 @@
+#include "TextureImage.h"
+
+#include <iostream>
+
+// Única unidade de tradução com a implementação da stb_image; os exercícios
+// só incluem o cabeçalho
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+using namespace std;
+
+TextureImage::~TextureImage()
+{
+    stbi_image_free(data);
+}
+
+bool decodeTexture(const string& path, TextureImage& image, bool flipVertically, int channels)
+{
+    image.path = path;
+    stbi_set_flip_vertically_on_load_thread(flipVertically);
+    int fileChannels = 0;
+    image.data = stbi_load(path.c_str(), &image.width, &image.height, &fileChannels, channels);
+    if (!image.data) {
+        cout << "Falha ao carregar textura: " << path << " (" << stbi_failure_reason() << ")" << endl;
+        return false;
+    }
+    image.channels = channels > 0 ? channels : fileChannels;
+
+    const char* layouts[] = { "?", "cinza", "cinza+alfa", "RGB", "RGBA" };
+    cout << "Textura carregada: " << path << " (" << image.width << "x" << image.height << ", "
+         << layouts[fileChannels];
+    if (image.channels != fileChannels)
+        cout << " -> " << layouts[image.channels];
+    cout << ")" << endl;
+    return true;
+}
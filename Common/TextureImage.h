@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Imagem decodificada na CPU, ainda sem textura GL. Pode ser criada em uma
+// thread de trabalho e enviada depois pela thread do GL.
+struct TextureImage
+{
+    std::string path;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    unsigned char* data = nullptr; // alocado pela stb_image
+
+    TextureImage() = default;
+    ~TextureImage();
+
+    TextureImage(const TextureImage&) = delete;
+    TextureImage& operator=(const TextureImage&) = delete;
+
+    // Tamanho dos pixels decodificados, em bytes
+    size_t bytes() const { return (size_t)width * height * channels; }
+};
+
+// Lê e decodifica o arquivo com a stb_image, sem usar OpenGL; pode rodar em
+// qualquer thread (a inversão vertical é configurada só para a thread atual).
+// `channels` > 0 converte para esse número de canais já na decodificação
+// (4 = RGBA, com linhas sempre alinhadas a 4 bytes para o envio).
+bool decodeTexture(const std::string& path, TextureImage& image, bool flipVertically = true, int channels = 0);
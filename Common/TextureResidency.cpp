@@ -0,0 +1,258 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+TextureResidency::~TextureResidency()
+{
+    destroy();
+}
+
+size_t TextureResidency::bytesFrom(const Entry& entry, uint32_t level) const
+{
+    size_t bytes = 0;
+    for (size_t i = level; i < entry.levelBytes.size(); i++)
+        bytes += entry.levelBytes[i];
+    return bytes;
+}
+
+size_t TextureResidency::fullBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& texture : textures)
+        bytes += bytesFrom(texture.second, 0);
+    return bytes;
+}
+
+// Envia o nível da textura vinculada em GL_TEXTURE_2D, do .ctex mapeado
+void TextureResidency::uploadLevel(const Entry& entry, uint32_t index)
+{
+    const PreparedTexture& source = *entry.source;
+    const TextureLevel& level = source.levels[index];
+    const uint8_t* pixels = source.data + level.offset;
+    if (entry.format == TEXTURE_RGBA8) {
+        vector<uint8_t> rgba;
+        if (source.format != TEXTURE_RGBA8) {
+            rgba.resize((size_t)level.width * level.height * 4);
+            decompressLevel(source.format, pixels, level.width, level.height, rgba.data());
+            pixels = rgba.data();
+        }
+        glTexImage2D(GL_TEXTURE_2D, (GLint)index, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     pixels);
+    }
+    else
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)index, textureInternalFormat(entry.format), level.width,
+                               level.height, 0, (GLsizei)level.size, pixels);
+}
+
+// Sobe a base reespecificando os níveis que saem com tamanho zero, ou desce
+// reenviando os que voltam; a base só muda quando os níveis dela existem
+void TextureResidency::setBaseLevel(GLuint texture, Entry& entry, uint32_t level)
+{
+    if (level == entry.baseLevel)
+        return;
+
+    GLint boundTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (level > entry.baseLevel) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level);
+        for (uint32_t i = entry.baseLevel; i < level; i++) {
+            if (entry.format == TEXTURE_RGBA8)
+                glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            else
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, textureInternalFormat(entry.format), 0, 0, 0, 0,
+                                       nullptr);
+            resident -= entry.levelBytes[i];
+            current.droppedBytes += entry.levelBytes[i];
+            current.droppedLevels++;
+        }
+        entry.drops++;
+    }
+    else {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        for (uint32_t i = level; i < entry.baseLevel; i++) {
+            uploadLevel(entry, i);
+            resident += entry.levelBytes[i];
+            current.restoredBytes += entry.levelBytes[i];
+            current.restoredLevels++;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level);
+        entry.restores++;
+    }
+    entry.baseLevel = level;
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+}
+
+// Tira um nível da textura que menos faz falta: com detalhe além do pedido,
+// depois fora de uso (a usada há mais tempo) e, se `onlyIdle` for false, das
+// em uso a que tem o maior nível residente. False se nenhuma pode ser reduzida.
+bool TextureResidency::dropOne(GLuint except, bool onlyIdle)
+{
+    GLuint victim = 0;
+    int victimRank = 3;
+    for (auto& texture : textures) {
+        const Entry& entry = texture.second;
+        if (texture.first == except || entry.baseLevel >= entry.floorLevel)
+            continue;
+        bool used = entry.lastUsed + 1 >= frame;
+        int rank = entry.baseLevel < entry.wantedLevel ? 0 : !used ? 1 : 2;
+        if (rank == 2 && onlyIdle)
+            continue;
+        if (rank > victimRank)
+            continue;
+        if (rank == victimRank) {
+            const Entry& chosen = textures[victim];
+            bool better = rank == 2 ? entry.levelBytes[entry.baseLevel] > chosen.levelBytes[chosen.baseLevel]
+                                    : entry.lastUsed < chosen.lastUsed;
+            if (!better)
+                continue;
+        }
+        victim = texture.first;
+        victimRank = rank;
+    }
+    if (victimRank == 3)
+        return false;
+    Entry& entry = textures[victim];
+    setBaseLevel(victim, entry, entry.baseLevel + 1);
+    return true;
+}
+
+GLuint TextureResidency::loadTexture(shared_ptr<PreparedTexture> texture)
+{
+    if (!texture || texture->levels.empty())
+        return 0;
+
+    Entry entry;
+    entry.source = texture;
+    entry.format = textureFormatSupported(texture->format) ? texture->format : TEXTURE_RGBA8;
+    entry.floorLevel = (uint32_t)texture->levels.size() - 1;
+    for (size_t i = 0; i < texture->levels.size(); i++) {
+        const TextureLevel& level = texture->levels[i];
+        entry.levelBytes.push_back(textureLevelBytes(entry.format, level.width, level.height));
+        if (max(level.width, level.height) <= minLevelSize && i < entry.floorLevel)
+            entry.floorLevel = (uint32_t)i;
+    }
+    entry.lastUsed = frame;
+
+    // Abre espaço nas texturas fora de uso; o que ainda não couber fica para update
+    while (resident + bytesFrom(entry, entry.baseLevel) > budgetBytes && dropOne(0, true))
+        ;
+    while (resident + bytesFrom(entry, entry.baseLevel) > budgetBytes && entry.baseLevel < entry.floorLevel)
+        entry.baseLevel++;
+
+    GLint boundTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+    GLuint texID;
+    glGenTextures(1, &texID);
+    glBindTexture(GL_TEXTURE_2D, texID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)entry.baseLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)texture->levels.size() - 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (uint32_t i = entry.baseLevel; i < texture->levels.size(); i++)
+        uploadLevel(entry, i);
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+
+    resident += bytesFrom(entry, entry.baseLevel);
+    if (entry.baseLevel > 0)
+        cout << "Textura reduzida para o orçamento: " << texture->path << " a partir do nível " << entry.baseLevel
+             << " (" << bytesFrom(entry, entry.baseLevel) / 1024 << " de " << bytesFrom(entry, 0) / 1024 << " KB)"
+             << endl;
+    textures[texID] = std::move(entry);
+    return texID;
+}
+
+void TextureResidency::release(GLuint texture)
+{
+    auto found = textures.find(texture);
+    if (found == textures.end())
+        return;
+    resident -= bytesFrom(found->second, found->second.baseLevel);
+    textures.erase(found);
+    glDeleteTextures(1, &texture);
+}
+
+void TextureResidency::destroy()
+{
+    for (auto& texture : textures)
+        glDeleteTextures(1, &texture.first);
+    textures.clear();
+    resident = 0;
+}
+
+void TextureResidency::touch(GLuint texture, float screenPixels)
+{
+    auto found = textures.find(texture);
+    if (found == textures.end())
+        return;
+    Entry& entry = found->second;
+
+    uint32_t level = 0;
+    float largest = (float)max(entry.source->width, entry.source->height);
+    if (screenPixels > 0.0f && largest > screenPixels)
+        level = min((uint32_t)floor(log2(largest / screenPixels)), entry.floorLevel);
+    entry.wantedLevel = entry.lastUsed == frame ? min(entry.wantedLevel, level) : level;
+    entry.lastUsed = frame;
+}
+
+TextureResidencyStats TextureResidency::update()
+{
+    auto start = chrono::steady_clock::now();
+
+    // Em uso e sem todos os níveis pedidos: as mais próximas primeiro
+    vector<GLuint> restore;
+    for (auto& texture : textures)
+        if (texture.second.lastUsed == frame && texture.second.baseLevel > texture.second.wantedLevel)
+            restore.push_back(texture.first);
+    sort(restore.begin(), restore.end(),
+         [this](GLuint a, GLuint b) { return textures[a].wantedLevel < textures[b].wantedLevel; });
+
+    size_t restored = 0;
+    for (GLuint texture : restore) {
+        Entry& entry = textures[texture];
+        while (entry.baseLevel > entry.wantedLevel) {
+            size_t need = entry.levelBytes[entry.baseLevel - 1];
+            if (restored > 0 && restored + need > restoreBytesPerFrame)
+                break;
+            while (resident + need > budgetBytes && dropOne(texture, true))
+                ;
+            if (resident + need > budgetBytes)
+                break;
+            setBaseLevel(texture, entry, entry.baseLevel - 1);
+            restored += need;
+        }
+    }
+
+    while (resident > budgetBytes && dropOne(0, false))
+        ;
+
+    frame++;
+    TextureResidencyStats stats = current;
+    stats.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    current = TextureResidencyStats();
+    return stats;
+}
+
+void TextureResidency::printStats() const
+{
+    cout << "Texturas na GPU: " << resident / 1024 << " KB de " << fullBytes() / 1024
+         << " KB com todos os níveis (orçamento " << budgetBytes / 1024 << " KB)" << endl;
+    for (const auto& texture : textures) {
+        const Entry& entry = texture.second;
+        const TextureLevel& base = entry.source->levels[entry.baseLevel];
+        cout << "  " << entry.source->path << " (" << textureFormatName(entry.format) << "): nível base "
+             << entry.baseLevel << " (" << base.width << "x" << base.height << "), "
+             << bytesFrom(entry, entry.baseLevel) / 1024 << " de " << bytesFrom(entry, 0) / 1024 << " KB, pede o nível "
+             << entry.wantedLevel << ", " << entry.drops << " reduções e " << entry.restores
+             << " restaurações, usada há " << (frame - 1 > entry.lastUsed ? frame - 1 - entry.lastUsed : 0) << " quadros"
+             << endl;
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "TextureContainer.h"
+
+// Orçamento de memória de textura. Cada textura criada por loadTexture é
+// contada pelos níveis que tem na GPU, no formato enviado; quando a soma passa
+// de `budgetBytes`, os níveis mais finos saem: GL_TEXTURE_BASE_LEVEL sobe e os
+// níveis abaixo da base são reespecificados com tamanho zero, para o driver
+// liberar a memória. Saem primeiro os níveis que a distância já dispensa (mais
+// finos que o pedido em touch), depois os das texturas usadas há mais tempo,
+// um nível por vez, e por fim os maiores das texturas em uso. Quando há espaço
+// os níveis voltam, lidos de novo do .ctex mapeado, para as texturas em uso.
+// A cena perde nitidez em vez de ficar sem memória. Deve ser usado na thread
+// do contexto GL.
+//
+// Os arrays de TextureArrays.h e o cache de VirtualTexture.h não passam por
+// aqui: o array divide a base entre todas as camadas e o cache já tem tamanho
+// fixo.
+
+// O que update() fez em um quadro (inclui as reduções feitas por loadTexture)
+struct TextureResidencyStats
+{
+    size_t droppedLevels = 0;
+    size_t droppedBytes = 0;
+    size_t restoredLevels = 0;
+    size_t restoredBytes = 0;
+    double ms = 0.0;
+};
+
+struct TextureResidency
+{
+    size_t budgetBytes = 256 << 20;
+    size_t restoreBytesPerFrame = 16 << 20; // reenvios por quadro, para não travar o quadro
+    uint32_t minLevelSize = 64;             // nunca reduz abaixo do primeiro nível com o maior lado <= isto
+
+    TextureResidency() = default;
+    ~TextureResidency();
+
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    // Cria a GL_TEXTURE_2D (GL_REPEAT, filtro trilinear) com os
+    // níveis que cabem no orçamento, reduzindo antes as texturas fora de uso;
+    // os demais níveis voltam em update. Guarda `texture`, que mantém o .ctex
+    // mapeado para os reenvios. 0 se `texture` não tiver níveis.
+    GLuint loadTexture(std::shared_ptr<PreparedTexture> texture);
+
+    // Apaga a textura e deixa de contá-la
+    void release(GLuint texture);
+    void destroy();
+
+    // A textura será desenhada neste quadro cobrindo cerca de `screenPixels`
+    // pixels no maior lado (0 = tamanho desconhecido: quer o nível 0). Várias
+    // chamadas no mesmo quadro ficam com o nível mais fino pedido.
+    void touch(GLuint texture, float screenPixels = 0.0f);
+
+    // Fim do quadro: devolve níveis às texturas em uso, se couberem, e reduz
+    // até voltar ao orçamento
+    TextureResidencyStats update();
+
+    size_t residentBytes() const { return resident; }
+    size_t fullBytes() const; // o que as mesmas texturas ocupariam com todos os níveis
+
+    // Ocupação total e de cada textura
+    void printStats() const;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<PreparedTexture> source;
+        TextureFormat format = TEXTURE_RGBA8; // enviado (RGBA8 se o driver não aceitar o BCn)
+        std::vector<size_t> levelBytes;
+        uint32_t baseLevel = 0;   // nível mais fino residente
+        uint32_t wantedLevel = 0; // o mais fino que os touch do último uso pediram
+        uint32_t floorLevel = 0;  // o mais grosso a que pode ser reduzida
+        uint64_t lastUsed = 0;    // quadro do último touch
+        size_t drops = 0;
+        size_t restores = 0;
+    };
+
+    size_t bytesFrom(const Entry& entry, uint32_t level) const;
+    void uploadLevel(const Entry& entry, uint32_t level);
+    void setBaseLevel(GLuint texture, Entry& entry, uint32_t level);
+    bool dropOne(GLuint except, bool onlyIdle);
+
+    std::map<GLuint, Entry> textures;
+    size_t resident = 0;
+    uint64_t frame = 1;
+    TextureResidencyStats current;
+};
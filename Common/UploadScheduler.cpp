@@ -0,0 +1,249 @@
+#include "UploadScheduler.h"
+#include "MeshCache.h"
+#include "PixelUploadRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+void UploadScheduler::enqueueBuffer(GLuint buffer, const void* data, size_t size, shared_ptr<const void> keepAlive)
+{
+    Step step;
+    step.kind = Step::STEP_BUFFER;
+    step.object = buffer;
+    step.data = static_cast<const unsigned char*>(data);
+    step.size = size;
+    step.keepAlive = std::move(keepAlive);
+    steps.push_back(std::move(step));
+    queuedBytes += size;
+}
+
+void UploadScheduler::enqueueTexture(GLuint texture, GLint level, GLsizei width, GLsizei height, GLenum format,
+                                     size_t bytesPerPixel, const void* pixels, shared_ptr<const void> keepAlive,
+                                     GLint layer)
+{
+    Step step;
+    step.kind = Step::STEP_TEXTURE;
+    step.object = texture;
+    step.data = static_cast<const unsigned char*>(pixels);
+    step.level = level;
+    step.layer = layer;
+    step.width = width;
+    step.height = height;
+    step.format = format;
+    step.rowBytes = width * bytesPerPixel;
+    step.size = step.rowBytes * height;
+    step.keepAlive = std::move(keepAlive);
+    queuedBytes += step.size;
+    steps.push_back(std::move(step));
+}
+
+void UploadScheduler::enqueueCompressedTexture(GLuint texture, GLint level, GLsizei width, GLsizei height,
+                                               GLenum internalFormat, size_t blockBytes, const void* data,
+                                               shared_ptr<const void> keepAlive, GLint layer)
+{
+    Step step;
+    step.kind = Step::STEP_TEXTURE;
+    step.object = texture;
+    step.data = static_cast<const unsigned char*>(data);
+    step.level = level;
+    step.layer = layer;
+    step.width = width;
+    step.height = height;
+    step.format = internalFormat;
+    step.compressed = true;
+    step.rowBytes = ((width + 3) / 4) * blockBytes;
+    step.size = step.rowBytes * ((height + 3) / 4);
+    step.keepAlive = std::move(keepAlive);
+    queuedBytes += step.size;
+    steps.push_back(std::move(step));
+}
+
+void UploadScheduler::enqueueMipmaps(GLuint texture)
+{
+    Step step;
+    step.kind = Step::STEP_MIPMAPS;
+    step.object = texture;
+    steps.push_back(std::move(step));
+}
+
+void UploadScheduler::enqueueCallback(function<void()> done)
+{
+    Step step;
+    step.kind = Step::STEP_CALLBACK;
+    step.done = std::move(done);
+    steps.push_back(std::move(step));
+}
+
+// Envia o próximo pedaço do passo e retorna quantos bytes foram copiados
+size_t UploadScheduler::runChunk(Step& step)
+{
+    switch (step.kind) {
+    case Step::STEP_BUFFER: {
+        size_t count = min(chunkBytes, step.size - step.offset);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, step.object);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, step.offset, count, step.data + step.offset);
+        step.offset += count;
+        return count;
+    }
+    case Step::STEP_TEXTURE: {
+        // Faixa de linhas inteiras (de blocos 4x4, se comprimida); pelo menos
+        // uma linha por chamada
+        size_t rowHeight = step.compressed ? 4 : 1;
+        size_t firstRow = step.offset / step.rowBytes;
+        size_t rows = max<size_t>(1, chunkBytes / step.rowBytes);
+        rows = min(rows, (step.height + rowHeight - 1) / rowHeight - firstRow);
+        size_t count = rows * step.rowBytes;
+        GLint y = (GLint)(firstRow * rowHeight);
+        GLsizei height = (GLsizei)min(rows * rowHeight, step.height - firstRow * rowHeight);
+        const void* pixels = step.data + step.offset;
+        if (pixelRing && pixelRing->created() && count <= pixelRing->bufferBytes) {
+            // Anel cheio: 0 bytes encerra o quadro, a faixa fica para o próximo
+            void* staging = pixelRing->begin(count);
+            if (!staging)
+                return 0;
+            memcpy(staging, pixels, count);
+            if (step.compressed)
+                pixelRing->endCompressedTexture(step.object, step.level, y, step.width, height, step.format, count,
+                                                step.layer);
+            else
+                pixelRing->endTexture(step.object, step.level, y, step.width, height, step.format, step.layer);
+        }
+        else if (step.layer >= 0) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, step.object);
+            if (step.compressed)
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, step.level, 0, y, step.layer, step.width, height, 1,
+                                          step.format, (GLsizei)count, pixels);
+            else
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, step.level, 0, y, step.layer, step.width, height, 1, step.format,
+                                GL_UNSIGNED_BYTE, pixels);
+        }
+        else {
+            glBindTexture(GL_TEXTURE_2D, step.object);
+            if (step.compressed)
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, step.level, 0, y, step.width, height, step.format,
+                                          (GLsizei)count, pixels);
+            else
+                glTexSubImage2D(GL_TEXTURE_2D, step.level, 0, y, step.width, height, step.format, GL_UNSIGNED_BYTE,
+                                pixels);
+        }
+        step.offset += count;
+        return count;
+    }
+    case Step::STEP_MIPMAPS:
+        glBindTexture(GL_TEXTURE_2D, step.object);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        return 0;
+    case Step::STEP_CALLBACK:
+        step.done();
+        return 0;
+    }
+    return 0;
+}
+
+UploadStats UploadScheduler::update()
+{
+    UploadStats stats;
+    if (steps.empty()) {
+        lastFrame = stats;
+        return stats;
+    }
+
+    // As texturas passam pelo GL_TEXTURE_2D (ou GL_TEXTURE_2D_ARRAY) da
+    // unidade ativa; os vínculos do quadro e o alinhamento de leitura são
+    // restaurados no fim. Linhas RGB não têm alinhamento de 4 bytes.
+    GLint boundTexture = 0, boundArray = 0, unpackAlignment = 4;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &boundArray);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    auto start = chrono::steady_clock::now();
+    while (!steps.empty()) {
+        // push_back no deque (um callback pode enfileirar mais passos) não
+        // invalida a referência
+        Step& step = steps.front();
+        auto chunkStart = chrono::steady_clock::now();
+        size_t bytes = runChunk(step);
+        if (step.kind == Step::STEP_TEXTURE) {
+            if (bytes == 0) {
+                stats.ringFullFrames = 1;
+                break;
+            }
+            stats.textureBytes += bytes;
+            stats.textureMs += chrono::duration<double, milli>(chrono::steady_clock::now() - chunkStart).count();
+        }
+        stats.bytes += bytes;
+        if (step.kind != Step::STEP_CALLBACK)
+            stats.chunks++;
+        queuedBytes -= bytes;
+
+        if (step.offset >= step.size)
+            steps.pop_front();
+
+        stats.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (stats.ms >= budgetMs || stats.bytes >= budgetBytes)
+            break;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, boundArray);
+
+    stats.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    stats.pendingBytes = queuedBytes;
+    lastFrame = stats;
+    total.bytes += stats.bytes;
+    total.chunks += stats.chunks;
+    total.ms += stats.ms;
+    total.textureBytes += stats.textureBytes;
+    total.textureMs += stats.textureMs;
+    total.ringFullFrames += stats.ringFullFrames;
+    total.pendingBytes = queuedBytes;
+    busyFrames++;
+    worstFrameMs = max(worstFrameMs, stats.ms);
+    return stats;
+}
+
+void uploadPreparedMeshScheduled(UploadScheduler& scheduler, shared_ptr<PreparedMesh> prepared, const glm::vec3& color,
+                                 function<void(GpuMesh&)> ready)
+{
+    // Só aloca o armazenamento; a cópia vem pela fila
+    GpuMesh gpu = uploadMeshData(nullptr, prepared->vertexCount, prepared->format, prepared->dequant, nullptr,
+                                 prepared->indexCount, prepared->indexType);
+    gpu.color = color;
+    gpu.ranges = prepared->ranges;
+    gpu.lods = prepared->lods;
+    gpu.meshlets = prepared->meshlets;
+    gpu.materials = prepared->materials;
+    gpu.materialLibrary = prepared->materialLibrary;
+
+    scheduler.enqueueBuffer(gpu.VBO, prepared->vertices, prepared->vertexBytes, prepared);
+    scheduler.enqueueBuffer(gpu.EBO, prepared->indices, prepared->indexBytes, prepared);
+    scheduler.enqueueCallback([gpu, ready]() mutable { ready(gpu); });
+}
+
+void uploadTextureScheduled(UploadScheduler& scheduler, GLsizei width, GLsizei height, int channels,
+                            const void* pixels, shared_ptr<const void> keepAlive, function<void(GLuint)> ready)
+{
+    GLenum format = channels == 3 ? GL_RGB : GL_RGBA;
+
+    GLint boundTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+
+    GLuint texID;
+    glGenTextures(1, &texID);
+    glBindTexture(GL_TEXTURE_2D, texID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+
+    scheduler.enqueueTexture(texID, 0, width, height, format, channels == 3 ? 3 : 4, pixels, std::move(keepAlive));
+    scheduler.enqueueMipmaps(texID);
+    scheduler.enqueueCallback([texID, ready] { ready(texID); });
+}
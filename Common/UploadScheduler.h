@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include <glad/glad.h>
+
+#include "Mesh.h"
+
+struct PixelUploadRing;
+struct PreparedMesh;
+
+// Quanto foi enviado em um quadro
+struct UploadStats
+{
+    size_t bytes = 0;        // bytes copiados para buffers e texturas
+    size_t chunks = 0;       // chamadas glBufferSubData/glTex(Compressed)SubImage/glGenerateMipmap
+    double ms = 0.0;         // tempo de CPU gasto nas chamadas
+    size_t pendingBytes = 0; // ainda na fila ao fim do quadro
+
+    // Só as faixas de textura: o tempo de CPU por MB mede quanto o envio
+    // trava a thread (cópia síncrona do driver ou memcpy para o PBO)
+    size_t textureBytes = 0;
+    double textureMs = 0.0;
+    size_t ringFullFrames = 0; // quadros encerrados porque o anel de PBOs estava todo em uso
+};
+
+// Fatia os envios para a GPU em pedaços e gasta no máximo `budgetMs`
+// milissegundos ou `budgetBytes` bytes por quadro, para que um modelo ou uma
+// textura grande não trave um quadro inteiro. Os buffers e texturas de destino
+// já devem ter o armazenamento alocado (glBufferData/glTexImage2D com dados
+// nulos); a fila só copia os dados. Deve ser usado na thread do contexto GL.
+//
+// O tempo medido é o de CPU dentro das chamadas GL; o driver pode fazer parte
+// da cópia mais tarde, então o orçamento é uma aproximação.
+struct UploadScheduler
+{
+    double budgetMs = 2.0;
+    size_t budgetBytes = 4 << 20;
+    size_t chunkBytes = 256 << 10; // tamanho de cada glBufferSubData / faixa de linhas
+
+    // Com um anel de PBOs, as faixas de textura (também as comprimidas) são
+    // copiadas para ele e glTexSubImage lê do PBO; sem, lê direto da memória de origem
+    PixelUploadRing* pixelRing = nullptr;
+
+    // Copia `size` bytes para `buffer`, de `chunkBytes` em `chunkBytes`, pelo
+    // alvo GL_COPY_WRITE_BUFFER (não mexe no EBO do VAO ativo). `keepAlive`
+    // segura a memória de `data` até o fim da cópia.
+    void enqueueBuffer(GLuint buffer, const void* data, size_t size, std::shared_ptr<const void> keepAlive);
+
+    // Copia um nível de uma textura 2D em faixas de linhas de até `chunkBytes`;
+    // com `layer` >= 0, a camada `layer` do nível de um GL_TEXTURE_2D_ARRAY
+    void enqueueTexture(GLuint texture, GLint level, GLsizei width, GLsizei height, GLenum format,
+                        size_t bytesPerPixel, const void* pixels, std::shared_ptr<const void> keepAlive,
+                        GLint layer = -1);
+
+    // Como enqueueTexture, para um nível já comprimido (BCn) no formato interno
+    // `internalFormat`: as faixas são de linhas de blocos 4x4, cada uma com
+    // `blockBytes` bytes por bloco
+    void enqueueCompressedTexture(GLuint texture, GLint level, GLsizei width, GLsizei height, GLenum internalFormat,
+                                  size_t blockBytes, const void* data, std::shared_ptr<const void> keepAlive,
+                                  GLint layer = -1);
+
+    // Gera os mipmaps de `texture` como um passo próprio da fila
+    void enqueueMipmaps(GLuint texture);
+
+    // Roda depois que todos os envios anteriores terminarem
+    void enqueueCallback(std::function<void()> done);
+
+    // Chamar uma vez por quadro. Sempre avança pelo menos um pedaço, mesmo que
+    // ele sozinho passe do orçamento.
+    UploadStats update();
+
+    bool idle() const { return steps.empty(); }
+
+    UploadStats lastFrame;
+    UploadStats total;
+    size_t busyFrames = 0; // quadros em que houve envio
+    double worstFrameMs = 0.0;
+
+private:
+    struct Step
+    {
+        enum Kind { STEP_BUFFER, STEP_TEXTURE, STEP_MIPMAPS, STEP_CALLBACK } kind = STEP_CALLBACK;
+        GLuint object = 0;
+        const unsigned char* data = nullptr;
+        size_t size = 0;   // bytes totais
+        size_t offset = 0; // bytes já enviados
+        GLint level = 0;
+        GLint layer = -1;
+        GLsizei width = 0, height = 0;
+        GLenum format = 0;   // formato dos pixels, ou o formato interno se comprimida
+        bool compressed = false;
+        size_t rowBytes = 0; // bytes de uma linha de pixels, ou de uma linha de blocos
+        std::shared_ptr<const void> keepAlive;
+        std::function<void()> done;
+    };
+
+    size_t runChunk(Step& step);
+
+    std::deque<Step> steps;
+    size_t queuedBytes = 0;
+};
+
+// Cria VAO/VBO/EBO vazios para a malha e agenda a cópia dos vértices e índices;
+// `ready` recebe a malha quando o último pedaço chegar à GPU
+void uploadPreparedMeshScheduled(UploadScheduler& scheduler, std::shared_ptr<PreparedMesh> prepared,
+                                 const glm::vec3& color, std::function<void(GpuMesh&)> ready);
+
+// Aloca uma textura RGB ou RGBA de 8 bits e agenda o nível 0 e os mipmaps;
+// `ready` recebe a textura quando ela estiver completa
+void uploadTextureScheduled(UploadScheduler& scheduler, GLsizei width, GLsizei height, int channels,
+                            const void* pixels, std::shared_ptr<const void> keepAlive,
+                            std::function<void(GLuint)> ready);
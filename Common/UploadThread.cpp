@@ -0,0 +1,156 @@
+#include "UploadThread.h"
+#include "MeshCache.h"
+
+#include <iostream>
+
+using namespace std;
+
+UploadThread::~UploadThread()
+{
+    stop();
+}
+
+bool UploadThread::start(GLFWwindow* mainWindow)
+{
+    if (context)
+        return true;
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context = glfwCreateWindow(1, 1, "upload", nullptr, mainWindow);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!context) {
+        cout << "Contexto de envio compartilhado indisponível; envios ficam na thread principal" << endl;
+        return false;
+    }
+
+    stopping = false;
+    worker = thread(&UploadThread::threadLoop, this);
+    return true;
+}
+
+void UploadThread::stop()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    if (!context)
+        return;
+    wake.notify_all();
+    worker.join();
+
+    // Objetos de sincronização são compartilhados; os resultados sem `finish`
+    // são descartados
+    for (Job& job : fenced)
+        glDeleteSync(job.fence);
+    for (Job& job : waiting)
+        glDeleteSync(job.fence);
+    queued.clear();
+    fenced.clear();
+    waiting.clear();
+    inFlight = 0;
+
+    glfwDestroyWindow(context);
+    context = nullptr;
+}
+
+void UploadThread::submit(function<void()> upload, function<void()> finish)
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (stopping)
+            return;
+        inFlight++;
+        queued.push_back(Job{ std::move(upload), std::move(finish) });
+    }
+    wake.notify_one();
+}
+
+void UploadThread::threadLoop()
+{
+    glfwMakeContextCurrent(context);
+
+    for (;;) {
+        Job job;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            wake.wait(lock, [this] { return stopping || !queued.empty(); });
+            if (stopping)
+                break;
+            job = std::move(queued.front());
+            queued.pop_front();
+        }
+
+        job.upload();
+
+        // O flush garante que a fence chegue à GPU e fique visível ao outro contexto
+        job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        lock_guard<mutex> lock(queueMutex);
+        fenced.push_back(std::move(job));
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+size_t UploadThread::poll()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        while (!fenced.empty()) {
+            waiting.push_back(std::move(fenced.front()));
+            fenced.pop_front();
+        }
+    }
+
+    // As fences de um mesmo contexto sinalizam em ordem; a primeira pendente
+    // encerra a verificação deste quadro
+    size_t count = 0;
+    while (!waiting.empty()) {
+        Job& job = waiting.front();
+        GLenum status = glClientWaitSync(job.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(job.fence);
+        function<void()> finish = std::move(job.finish);
+        waiting.pop_front();
+        inFlight--;
+        finish();
+        count++;
+    }
+    return count;
+}
+
+void uploadPreparedMeshThreaded(UploadThread& uploader, shared_ptr<PreparedMesh> prepared, const glm::vec3& color,
+                                function<void(GpuMesh&)> ready)
+{
+    auto gpu = make_shared<GpuMesh>();
+    uploader.submit(
+        [prepared, gpu] {
+            gpu->format = prepared->format;
+            gpu->dequant = prepared->dequant;
+            gpu->indexCount = (GLsizei)prepared->indexCount;
+            gpu->indexType = prepared->indexType;
+
+            // GL_COPY_WRITE_BUFFER não depende de VAO, que este contexto não tem
+            glGenBuffers(1, &gpu->VBO);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, gpu->VBO);
+            glBufferData(GL_COPY_WRITE_BUFFER, prepared->vertexBytes, prepared->vertices, GL_STATIC_DRAW);
+            glGenBuffers(1, &gpu->EBO);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, gpu->EBO);
+            glBufferData(GL_COPY_WRITE_BUFFER, prepared->indexBytes, prepared->indices, GL_STATIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        },
+        [prepared, gpu, color, ready] {
+            createMeshVertexArrays(*gpu, prepared->vertexCount);
+            gpu->color = color;
+            gpu->ranges = prepared->ranges;
+            gpu->lods = prepared->lods;
+            gpu->meshlets = prepared->meshlets;
+            gpu->materials = prepared->materials;
+            gpu->materialLibrary = prepared->materialLibrary;
+            ready(*gpu);
+        });
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Mesh.h"
+
+struct PreparedMesh;
+
+// Thread de envio com um contexto GL próprio, de uma janela oculta que
+// compartilha buffers e texturas com a janela principal. Cada envio roda
+// inteiro nesse contexto (glBufferData/glTexImage2D de qualquer tamanho) e é
+// seguido de um glFenceSync; poll(), na thread que desenha, só entrega o
+// resultado quando a fence já foi sinalizada, então o laço de renderização
+// nunca espera pela cópia.
+struct UploadThread
+{
+    UploadThread() = default;
+    ~UploadThread();
+
+    UploadThread(const UploadThread&) = delete;
+    UploadThread& operator=(const UploadThread&) = delete;
+
+    // Cria a janela oculta e a thread; chamar na thread principal (exigência
+    // da GLFW para criar janelas). Retorna false se o contexto compartilhado
+    // não puder ser criado, e nesse caso os envios devem ficar no contexto principal.
+    bool start(GLFWwindow* mainWindow);
+
+    // Termina a thread e destrói a janela oculta; também na thread principal
+    void stop();
+
+    bool running() const { return context != nullptr; }
+
+    // `upload` roda na thread de envio, com o contexto compartilhado ativo;
+    // `finish` roda depois em poll(), quando os comandos de `upload` já
+    // terminaram na GPU. Pode ser chamado de qualquer thread; depois de stop()
+    // o pedido é descartado.
+    void submit(std::function<void()> upload, std::function<void()> finish);
+
+    // Na thread que desenha: executa os `finish` cujas fences já foram
+    // sinalizadas, sem bloquear, e retorna quantos rodaram
+    size_t poll();
+
+    // Envios cujo `finish` ainda não rodou
+    size_t pending() const { return inFlight; }
+
+private:
+    struct Job
+    {
+        std::function<void()> upload;
+        std::function<void()> finish;
+        GLsync fence = nullptr;
+    };
+
+    void threadLoop();
+
+    GLFWwindow* context = nullptr;
+    std::thread worker;
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    std::deque<Job> queued;  // aguardando a thread de envio
+    std::deque<Job> fenced;  // enviados, aguardando poll()
+    std::deque<Job> waiting; // só da thread que desenha: fence ainda não sinalizada
+    bool stopping = false;
+    std::atomic<size_t> inFlight{0};
+};
+
+// Cria VBO/EBO com os dados da malha no contexto de envio e, quando a cópia
+// termina, os VAOs no contexto que desenha; `ready` recebe a malha pronta
+void uploadPreparedMeshThreaded(UploadThread& uploader, std::shared_ptr<PreparedMesh> prepared, const glm::vec3& color,
+                                std::function<void(GpuMesh&)> ready);
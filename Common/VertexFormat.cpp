@@ -0,0 +1,448 @@
+#include "VertexFormat.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VERTEX_FORMAT_SSE2 1
+#endif
+
+using namespace std;
+
+namespace {
+
+inline float signNotZero(float v)
+{
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+inline int16_t quantizeSnorm16(float v)
+{
+    return (int16_t)lround(glm::clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+inline uint16_t quantizeUnorm16(float v)
+{
+    return (uint16_t)lround(glm::clamp(v, 0.0f, 1.0f) * 65535.0f);
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3& n)
+{
+    float sum = fabs(n.x) + fabs(n.y) + fabs(n.z);
+    if (sum == 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec2 p(n.x / sum, n.y / sum);
+    if (n.z < 0.0f)
+        p = glm::vec2((1.0f - fabs(p.y)) * signNotZero(p.x), (1.0f - fabs(p.x)) * signNotZero(p.y));
+    return p;
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& e)
+{
+    glm::vec3 v(e.x, e.y, 1.0f - fabs(e.x) - fabs(e.y));
+    if (v.z < 0.0f) {
+        float x = (1.0f - fabs(v.y)) * signNotZero(v.x);
+        float y = (1.0f - fabs(v.x)) * signNotZero(v.y);
+        v.x = x;
+        v.y = y;
+    }
+    return glm::normalize(v);
+}
+
+uint32_t packInt2101010(const glm::vec3& n)
+{
+    int x = (int)lround(glm::clamp(n.x, -1.0f, 1.0f) * 511.0f);
+    int y = (int)lround(glm::clamp(n.y, -1.0f, 1.0f) * 511.0f);
+    int z = (int)lround(glm::clamp(n.z, -1.0f, 1.0f) * 511.0f);
+    return (uint32_t)(x & 0x3FF) | ((uint32_t)(y & 0x3FF) << 10) | ((uint32_t)(z & 0x3FF) << 20);
+}
+
+glm::vec3 unpackInt2101010(uint32_t packed)
+{
+    // Extensão de sinal de cada campo de 10 bits
+    auto field = [&](int shift) {
+        int v = (int)((packed >> shift) & 0x3FF);
+        return (float)(v >= 512 ? v - 1024 : v);
+    };
+    return glm::vec3(field(0), field(10), field(20));
+}
+
+size_t positionSize(PositionFormat f) { return f == POSITION_FLOAT ? 12 : 8; }
+size_t colorSize(ColorFormat f) { return f == COLOR_FLOAT ? 12 : f == COLOR_UNORM8 ? 4 : 0; }
+size_t normalSize(NormalFormat f) { return f == NORMAL_FLOAT ? 12 : 4; }
+size_t uvSize(UvFormat f) { return f == UV_FLOAT ? 8 : 4; }
+
+float angleDegrees(const glm::vec3& a, const glm::vec3& b)
+{
+    float la = glm::length(a), lb = glm::length(b);
+    if (la == 0.0f || lb == 0.0f)
+        return 0.0f;
+    float c = glm::clamp(glm::dot(a, b) / (la * lb), -1.0f, 1.0f);
+    return acos(c) * 57.2957795f;
+}
+
+} // namespace
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t f;
+    memcpy(&f, &value, sizeof(f));
+
+    uint32_t sign = (f >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((f >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = f & 0x7FFFFF;
+
+    // Infinito e NaN
+    if ((f & 0x7FFFFFFF) >= 0x7F800000)
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)
+        return (uint16_t)(sign | 0x7C00);
+
+    // Subnormal ou zero
+    if (exponent <= 0) {
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t h = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (h & 1)))
+            ++h;
+        return (uint16_t)(sign | h);
+    }
+
+    uint32_t h = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    // Um carry aqui sobe corretamente para o expoente (ou para infinito)
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+        ++h;
+    return (uint16_t)(sign | h);
+}
+
+float halfToFloat(uint16_t value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+
+    uint32_t f;
+    if (exponent == 0) {
+        float v = ldexp((float)mantissa, -24);
+        return sign ? -v : v;
+    }
+    if (exponent == 31)
+        f = sign | 0x7F800000 | (mantissa << 13);
+    else
+        f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+    float result;
+    memcpy(&result, &f, sizeof(result));
+    return result;
+}
+
+uint32_t packVertexFormat(const VertexFormat& format)
+{
+    return (uint32_t)format.position | ((uint32_t)format.color << 8) |
+           ((uint32_t)format.normal << 16) | ((uint32_t)format.uv << 24);
+}
+
+VertexFormat unpackVertexFormat(uint32_t packed)
+{
+    VertexFormat format;
+    format.position = (PositionFormat)(packed & 0xFF);
+    format.color = (ColorFormat)((packed >> 8) & 0xFF);
+    format.normal = (NormalFormat)((packed >> 16) & 0xFF);
+    format.uv = (UvFormat)((packed >> 24) & 0xFF);
+    return format;
+}
+
+VertexFormat resolveVertexFormat(const VertexFormat& format, bool hasColors)
+{
+    VertexFormat resolved = format;
+    if (!hasColors)
+        resolved.color = COLOR_NONE;
+    return resolved;
+}
+
+VertexLayout makeVertexLayout(const VertexFormat& format)
+{
+    VertexLayout layout;
+    GLuint stream = STREAM_POSITION;
+
+    auto add = [&](GLuint location, GLint size, GLenum type, GLboolean normalized, size_t bytes) {
+        GLsizei& stride = layout.strides[stream];
+        layout.attribs[layout.attribCount++] = { stream, location, size, type, normalized, (GLuint)stride };
+        stride += (GLsizei)bytes;
+    };
+
+    // Posição (location = 0)
+    if (format.position == POSITION_FLOAT)
+        add(0, 3, GL_FLOAT, GL_FALSE, positionSize(format.position));
+    else
+        add(0, 3, GL_SHORT, GL_FALSE, positionSize(format.position));
+
+    // Normal (location = 2); o shader normaliza, então a escala dos inteiros não importa
+    stream = STREAM_SHADING;
+    if (format.normal == NORMAL_FLOAT)
+        add(2, 3, GL_FLOAT, GL_FALSE, normalSize(format.normal));
+    else if (format.normal == NORMAL_INT_2_10_10_10)
+        add(2, 4, GL_INT_2_10_10_10_REV, GL_FALSE, normalSize(format.normal));
+    else
+        add(2, 2, GL_SHORT, GL_FALSE, normalSize(format.normal));
+
+    // UV (location = 3)
+    if (format.uv == UV_FLOAT)
+        add(3, 2, GL_FLOAT, GL_FALSE, uvSize(format.uv));
+    else if (format.uv == UV_HALF)
+        add(3, 2, GL_HALF_FLOAT, GL_FALSE, uvSize(format.uv));
+    else
+        add(3, 2, GL_UNSIGNED_SHORT, GL_FALSE, uvSize(format.uv));
+
+    // Cor (location = 1)
+    stream = STREAM_COLOR;
+    if (format.color == COLOR_FLOAT)
+        add(1, 3, GL_FLOAT, GL_FALSE, colorSize(format.color));
+    else if (format.color == COLOR_UNORM8)
+        add(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, colorSize(format.color));
+
+    for (GLsizei stride : layout.strides)
+        layout.vertexSize += stride;
+    return layout;
+}
+
+size_t streamOffset(const VertexLayout& layout, int stream, size_t vertexCount)
+{
+    size_t offset = 0;
+    for (int s = 0; s < stream; s++)
+        offset += ((size_t)layout.strides[s] * vertexCount + 15) & ~size_t(15);
+    return offset;
+}
+
+size_t vertexBufferSize(const VertexLayout& layout, size_t vertexCount)
+{
+    return streamOffset(layout, VERTEX_STREAM_COUNT, vertexCount);
+}
+
+Dequantization computeDequantization(const MeshVertex* vertices, size_t count, const VertexFormat& format)
+{
+    Dequantization dequant;
+    if (count == 0)
+        return dequant;
+
+    if (format.position == POSITION_SNORM16) {
+        glm::vec3 lo = vertices[0].position, hi = vertices[0].position;
+        for (size_t i = 1; i < count; i++) {
+            lo = glm::min(lo, vertices[i].position);
+            hi = glm::max(hi, vertices[i].position);
+        }
+        glm::vec3 half = (hi - lo) * 0.5f;
+        for (int k = 0; k < 3; k++)
+            if (half[k] <= 0.0f)
+                half[k] = 1.0f;
+        dequant.posScale = half / 32767.0f;
+        dequant.posOffset = (lo + hi) * 0.5f;
+    }
+
+    if (format.uv == UV_UNORM16) {
+        glm::vec2 lo = vertices[0].uv, hi = vertices[0].uv;
+        for (size_t i = 1; i < count; i++) {
+            lo = glm::min(lo, vertices[i].uv);
+            hi = glm::max(hi, vertices[i].uv);
+        }
+        glm::vec2 range = hi - lo;
+        for (int k = 0; k < 2; k++)
+            if (range[k] <= 0.0f)
+                range[k] = 1.0f;
+        dequant.uvScale = range / 65535.0f;
+        dequant.uvOffset = lo;
+    }
+
+    return dequant;
+}
+
+void encodeVertices(const MeshVertex* vertices, size_t count, const VertexFormat& format,
+                    const Dequantization& dequant, void* dst)
+{
+    VertexLayout layout = makeVertexLayout(format);
+    unsigned char* base = static_cast<unsigned char*>(dst);
+
+    // Cada byte é escrito uma única vez e em ordem dentro de cada fluxo, porque
+    // `dst` pode ser um buffer GL mapeado (memória write-combined): os strides
+    // são preenchidos por inteiro abaixo e só o alinhamento entre fluxos é zerado
+    for (int stream = 0; stream < VERTEX_STREAM_COUNT; stream++) {
+        size_t end = streamOffset(layout, stream, count) + (size_t)layout.strides[stream] * count;
+        memset(base + end, 0, streamOffset(layout, stream + 1, count) - end);
+    }
+
+    unsigned char* positions = base + streamOffset(layout, STREAM_POSITION, count);
+    unsigned char* shading = base + streamOffset(layout, STREAM_SHADING, count);
+    unsigned char* colors = base + streamOffset(layout, STREAM_COLOR, count);
+
+    glm::vec3 posInvScale = 1.0f / (dequant.posScale * 32767.0f);
+    glm::vec2 uvInvScale = 1.0f / (dequant.uvScale * 65535.0f);
+
+#ifdef VERTEX_FORMAT_SSE2
+    // Posição SNORM16 em SSE2: os 4 floats lidos a partir de `position` incluem
+    // color.r, zerado pela máscara antes de empacotar. Arredonda para o par
+    // mais próximo nos empates (o caminho escalar afasta do zero).
+    const __m128 simdOffset = _mm_setr_ps(dequant.posOffset.x, dequant.posOffset.y, dequant.posOffset.z, 0.0f);
+    const __m128 simdInvScale = _mm_setr_ps(posInvScale.x, posInvScale.y, posInvScale.z, 0.0f);
+    const __m128 simdMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 simdOne = _mm_set1_ps(1.0f);
+    const __m128 simdMinusOne = _mm_set1_ps(-1.0f);
+    const __m128 simdSnorm = _mm_set1_ps(32767.0f);
+#endif
+
+    for (size_t i = 0; i < count; i++) {
+        const MeshVertex& v = vertices[i];
+        unsigned char* p = positions + i * layout.strides[STREAM_POSITION];
+
+        if (format.position == POSITION_FLOAT) {
+            memcpy(p, &v.position, 12);
+        }
+        else {
+#ifdef VERTEX_FORMAT_SSE2
+            __m128 n = _mm_and_ps(_mm_loadu_ps(&v.position.x), simdMask);
+            n = _mm_mul_ps(_mm_sub_ps(n, simdOffset), simdInvScale);
+            n = _mm_min_ps(_mm_max_ps(n, simdMinusOne), simdOne);
+            __m128i q = _mm_cvtps_epi32(_mm_mul_ps(n, simdSnorm));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(q, q));
+#else
+            glm::vec3 n = (v.position - dequant.posOffset) * posInvScale;
+            int16_t q[4] = { quantizeSnorm16(n.x), quantizeSnorm16(n.y), quantizeSnorm16(n.z), 0 };
+            memcpy(p, q, 8);
+#endif
+        }
+
+        p = shading + i * layout.strides[STREAM_SHADING];
+        if (format.normal == NORMAL_FLOAT) {
+            memcpy(p, &v.normal, 12);
+        }
+        else if (format.normal == NORMAL_INT_2_10_10_10) {
+            uint32_t packed = packInt2101010(v.normal);
+            memcpy(p, &packed, 4);
+        }
+        else {
+            glm::vec2 e = encodeOctahedral(v.normal);
+            int16_t q[2] = { quantizeSnorm16(e.x), quantizeSnorm16(e.y) };
+            memcpy(p, q, 4);
+        }
+        p += normalSize(format.normal);
+
+        if (format.uv == UV_FLOAT) {
+            memcpy(p, &v.uv, 8);
+        }
+        else if (format.uv == UV_HALF) {
+            uint16_t h[2] = { floatToHalf(v.uv.x), floatToHalf(v.uv.y) };
+            memcpy(p, h, 4);
+        }
+        else {
+            glm::vec2 n = (v.uv - dequant.uvOffset) * uvInvScale;
+            uint16_t q[2] = { quantizeUnorm16(n.x), quantizeUnorm16(n.y) };
+            memcpy(p, q, 4);
+        }
+
+        p = colors + i * layout.strides[STREAM_COLOR];
+        if (format.color == COLOR_FLOAT) {
+            memcpy(p, &v.color, 12);
+        }
+        else if (format.color == COLOR_UNORM8) {
+            uint8_t c[4] = {
+                (uint8_t)lround(glm::clamp(v.color.r, 0.0f, 1.0f) * 255.0f),
+                (uint8_t)lround(glm::clamp(v.color.g, 0.0f, 1.0f) * 255.0f),
+                (uint8_t)lround(glm::clamp(v.color.b, 0.0f, 1.0f) * 255.0f),
+                255
+            };
+            memcpy(p, c, 4);
+        }
+    }
+}
+
+VertexErrorStats measureVertexError(const MeshVertex* vertices, size_t count, const VertexFormat& format,
+                                    const Dequantization& dequant, const void* encoded)
+{
+    VertexErrorStats stats;
+    if (count == 0)
+        return stats;
+
+    VertexLayout layout = makeVertexLayout(format);
+    const unsigned char* base = static_cast<const unsigned char*>(encoded);
+    const unsigned char* positions = base + streamOffset(layout, STREAM_POSITION, count);
+    const unsigned char* shading = base + streamOffset(layout, STREAM_SHADING, count);
+
+    glm::vec3 lo = vertices[0].position, hi = vertices[0].position;
+
+    for (size_t i = 0; i < count; i++) {
+        const MeshVertex& v = vertices[i];
+        const unsigned char* p = positions + i * layout.strides[STREAM_POSITION];
+        lo = glm::min(lo, v.position);
+        hi = glm::max(hi, v.position);
+
+        glm::vec3 position;
+        if (format.position == POSITION_FLOAT) {
+            memcpy(&position, p, 12);
+        }
+        else {
+            int16_t q[4];
+            memcpy(q, p, 8);
+            position = glm::vec3(q[0], q[1], q[2]) * dequant.posScale + dequant.posOffset;
+        }
+        p = shading + i * layout.strides[STREAM_SHADING];
+
+        glm::vec3 normal;
+        if (format.normal == NORMAL_FLOAT) {
+            memcpy(&normal, p, 12);
+        }
+        else if (format.normal == NORMAL_INT_2_10_10_10) {
+            uint32_t packed;
+            memcpy(&packed, p, 4);
+            normal = unpackInt2101010(packed);
+        }
+        else {
+            int16_t q[2];
+            memcpy(q, p, 4);
+            normal = decodeOctahedral(glm::vec2(q[0], q[1]) / 32767.0f);
+        }
+        p += normalSize(format.normal);
+
+        glm::vec2 uv;
+        if (format.uv == UV_FLOAT) {
+            memcpy(&uv, p, 8);
+        }
+        else if (format.uv == UV_HALF) {
+            uint16_t h[2];
+            memcpy(h, p, 4);
+            uv = glm::vec2(halfToFloat(h[0]), halfToFloat(h[1]));
+        }
+        else {
+            uint16_t q[2];
+            memcpy(q, p, 4);
+            uv = glm::vec2(q[0], q[1]) * dequant.uvScale + dequant.uvOffset;
+        }
+
+        stats.position = max(stats.position, glm::length(position - v.position));
+        stats.normalDegrees = max(stats.normalDegrees, angleDegrees(normal, v.normal));
+        stats.uv = max(stats.uv, max(fabs(uv.x - v.uv.x), fabs(uv.y - v.uv.y)));
+    }
+
+    glm::vec3 extent = hi - lo;
+    float size = max(extent.x, max(extent.y, extent.z));
+    stats.positionRel = size > 0.0f ? stats.position / size : 0.0f;
+    return stats;
+}
+
+void applyVertexLayout(const VertexLayout& layout, size_t vertexCount, unsigned streams)
+{
+    for (int i = 0; i < layout.attribCount; i++) {
+        const VertexAttrib& a = layout.attribs[i];
+        if (!(streams & (1u << a.stream)))
+            continue;
+        size_t offset = streamOffset(layout, a.stream, vertexCount) + a.offset;
+        glVertexAttribPointer(a.location, a.size, a.type, a.normalized, layout.strides[a.stream], (GLvoid*)(uintptr_t)offset);
+        glEnableVertexAttribArray(a.location);
+    }
+}
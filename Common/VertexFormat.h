@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+struct MeshVertex;
+
+// Formatos de armazenamento de cada atributo no VBO. Os formatos inteiros são
+// lidos sem normalização pela OpenGL; a conversão de volta para o intervalo
+// original fica nos uniforms de Dequantization (ver setMeshUniforms).
+enum PositionFormat : uint8_t
+{
+    POSITION_FLOAT,   // 3 x float (12 bytes)
+    POSITION_SNORM16  // 3 x int16 + padding (8 bytes), relativo à caixa envolvente
+};
+
+enum ColorFormat : uint8_t
+{
+    COLOR_FLOAT,      // 3 x float (12 bytes)
+    COLOR_UNORM8,     // 4 x uint8 normalizado (4 bytes)
+    COLOR_NONE        // sem cor por vértice: cor constante definida a cada draw
+};
+
+enum NormalFormat : uint8_t
+{
+    NORMAL_FLOAT,     // 3 x float (12 bytes)
+    NORMAL_INT_2_10_10_10, // GL_INT_2_10_10_10_REV (4 bytes)
+    NORMAL_OCT16      // octaedro em 2 x int16 (4 bytes), decodificado no shader
+};
+
+enum UvFormat : uint8_t
+{
+    UV_FLOAT,         // 2 x float (8 bytes)
+    UV_HALF,          // 2 x half float (4 bytes)
+    UV_UNORM16        // 2 x uint16 (4 bytes), relativo ao intervalo das UVs
+};
+
+struct VertexFormat
+{
+    PositionFormat position = POSITION_FLOAT;
+    ColorFormat color = COLOR_FLOAT;
+    NormalFormat normal = NORMAL_FLOAT;
+    UvFormat uv = UV_FLOAT;
+};
+
+// A cor só é gravada quando a malha de origem tem cor por vértice (ver
+// resolveVertexFormat); os tamanhos abaixo são sem cor / com cor.
+
+// Atributos em float: 32 / 44 bytes por vértice (44 = layout original dos exemplos)
+const VertexFormat VERTEX_FORMAT_FLOAT = { POSITION_FLOAT, COLOR_FLOAT, NORMAL_FLOAT, UV_FLOAT };
+// 16 / 20 bytes por vértice, sem mudanças na normal e na UV dentro do shader
+const VertexFormat VERTEX_FORMAT_COMPACT = { POSITION_SNORM16, COLOR_UNORM8, NORMAL_INT_2_10_10_10, UV_HALF };
+// 16 / 20 bytes por vértice, com normal em octaedro e UV de 16 bits (menor erro)
+const VertexFormat VERTEX_FORMAT_PRECISE = { POSITION_SNORM16, COLOR_UNORM8, NORMAL_OCT16, UV_UNORM16 };
+
+// Os atributos ficam em fluxos separados, um após o outro no mesmo VBO, para
+// que uma passada só de posição (profundidade, sombra) leia apenas o primeiro
+enum VertexStream
+{
+    STREAM_POSITION,  // posição (location 0)
+    STREAM_SHADING,   // normal (location 2) e UV (location 3), intercaladas
+    STREAM_COLOR,     // cor (location 1), opcional
+    VERTEX_STREAM_COUNT
+};
+
+// Máscaras de fluxos usadas por applyVertexLayout
+const unsigned STREAMS_POSITION = 1u << STREAM_POSITION;
+const unsigned STREAMS_ALL = (1u << VERTEX_STREAM_COUNT) - 1;
+
+// Uma linha da tabela de layout: fluxo e argumentos de glVertexAttribPointer
+struct VertexAttrib
+{
+    GLuint stream;
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset;    // dentro do vértice do fluxo
+};
+
+const int MAX_VERTEX_ATTRIBS = 4;
+
+struct VertexLayout
+{
+    VertexAttrib attribs[MAX_VERTEX_ATTRIBS];
+    int attribCount = 0;
+    GLsizei strides[VERTEX_STREAM_COUNT] = {}; // 0 = fluxo ausente
+    GLsizei vertexSize = 0;                    // soma dos strides
+};
+
+// Transformação que leva os valores armazenados de volta ao espaço do objeto:
+// posição = armazenada * posScale + posOffset, uv = armazenada * uvScale + uvOffset
+struct Dequantization
+{
+    glm::vec3 posScale = glm::vec3(1.0f);
+    glm::vec3 posOffset = glm::vec3(0.0f);
+    glm::vec2 uvScale = glm::vec2(1.0f);
+    glm::vec2 uvOffset = glm::vec2(0.0f);
+};
+
+// Maior erro de reconstrução medido após a codificação
+struct VertexErrorStats
+{
+    float position = 0.0f;    // distância, em unidades do objeto
+    float positionRel = 0.0f; // em relação à maior dimensão da malha
+    float normalDegrees = 0.0f;
+    float uv = 0.0f;
+};
+
+uint32_t packVertexFormat(const VertexFormat& format);
+VertexFormat unpackVertexFormat(uint32_t packed);
+
+// Formato efetivo de uma malha: sem cor por vértice, a cor vira COLOR_NONE
+VertexFormat resolveVertexFormat(const VertexFormat& format, bool hasColors);
+
+VertexLayout makeVertexLayout(const VertexFormat& format);
+
+// Onde começa cada fluxo e o tamanho total do buffer para `vertexCount`
+// vértices; cada fluxo começa alinhado em 16 bytes
+size_t streamOffset(const VertexLayout& layout, int stream, size_t vertexCount);
+size_t vertexBufferSize(const VertexLayout& layout, size_t vertexCount);
+
+// Calcula a transformação de dequantização a partir dos limites dos atributos
+Dequantization computeDequantization(const MeshVertex* vertices, size_t count, const VertexFormat& format);
+
+// Codifica os vértices nos fluxos do formato, escrevendo em `dst`
+// (vertexBufferSize(makeVertexLayout(format), count) bytes)
+void encodeVertices(const MeshVertex* vertices, size_t count, const VertexFormat& format,
+                    const Dequantization& dequant, void* dst);
+
+// Decodifica `encoded` e compara com os vértices originais
+VertexErrorStats measureVertexError(const MeshVertex* vertices, size_t count, const VertexFormat& format,
+                                    const Dequantization& dequant, const void* encoded);
+
+// Liga os atributos dos fluxos em `streams` a partir do VBO atualmente
+// vinculado; atributos de fluxos ausentes ficam desabilitados
+void applyVertexLayout(const VertexLayout& layout, size_t vertexCount, unsigned streams = STREAMS_ALL);
+
+// Conversões half float (IEEE 754 binary16), com arredondamento ao mais próximo
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
@@ -0,0 +1,489 @@
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+
+using namespace std;
+
+namespace {
+
+// Entrada da tabela (RGBA8): x e y da posição no cache, nível da página residente, 255 = válida
+uint32_t packEntry(int slotX, int slotY, int level)
+{
+    return (uint32_t)slotX | (uint32_t)slotY << 8 | (uint32_t)level << 16 | 0xFF000000u;
+}
+
+int entryLevel(uint32_t entry)
+{
+    return (entry >> 24) ? (int)(entry >> 16 & 0xFF) : VT_MAX_LEVELS;
+}
+
+int wrap(int value, int size)
+{
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+} // namespace
+
+VirtualTextureSystem::~VirtualTextureSystem()
+{
+    destroy();
+}
+
+VirtualTextureSystem::PageKey VirtualTextureSystem::pageKey(int texture, int level, int x, int y)
+{
+    return (uint64_t)texture << 48 | (uint64_t)level << 40 | (uint64_t)x << 20 | (uint64_t)y;
+}
+
+void VirtualTextureSystem::create(int width, int height)
+{
+    destroy();
+
+    int cacheSize = cachePages * VT_PAGE_SIZE;
+    glGenTextures(1, &cache);
+    glBindTexture(GL_TEXTURE_2D, cache);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    slots.assign((size_t)cachePages * cachePages, Slot());
+    freeSlots.clear();
+    for (int i = (int)slots.size() - 1; i >= 0; i--)
+        freeSlots.push_back(i);
+
+    feedbackWidth = max(1, width / VT_FEEDBACK_DIVISOR);
+    feedbackHeight = max(1, height / VT_FEEDBACK_DIVISOR);
+    glGenTextures(1, &feedbackColor);
+    glBindTexture(GL_TEXTURE_2D, feedbackColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, feedbackWidth, feedbackHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenRenderbuffers(1, &feedbackDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, feedbackWidth, feedbackHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &savedFbo);
+    glGenFramebuffers(1, &feedbackFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, feedbackFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackColor, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "Framebuffer de feedback incompleto" << endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, savedFbo);
+
+    glGenBuffers(2, readback);
+    for (GLuint buffer : readback) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)feedbackWidth * feedbackHeight * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readbackNext = 0;
+
+    pageBuffer.resize((size_t)VT_PAGE_SIZE * VT_PAGE_SIZE * 4);
+}
+
+void VirtualTextureSystem::destroy()
+{
+    for (Texture& texture : textures)
+        glDeleteTextures(1, &texture.indirection);
+    textures.clear();
+    byPath.clear();
+    resident.clear();
+    lru.clear();
+    slots.clear();
+    freeSlots.clear();
+
+    for (GLsync& fence : readbackFence) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (readback[0])
+        glDeleteBuffers(2, readback);
+    readback[0] = readback[1] = 0;
+    glDeleteFramebuffers(1, &feedbackFbo);
+    glDeleteRenderbuffers(1, &feedbackDepth);
+    glDeleteTextures(1, &feedbackColor);
+    glDeleteTextures(1, &cache);
+    feedbackFbo = feedbackDepth = feedbackColor = cache = 0;
+}
+
+uint32_t& VirtualTextureSystem::entry(Texture& texture, int level, int x, int y)
+{
+    return texture.table[(size_t)(texture.levelRows[level] + y) * texture.levelPages[0][0] + x];
+}
+
+// A página passa a valer para ela e para as páginas mais finas que ela
+// cobre, exceto as que já têm uma página residente mais fina
+void VirtualTextureSystem::mapPage(Texture& texture, int level, int x, int y, uint32_t value)
+{
+    for (int k = level; k >= 0; k--) {
+        int scale = 1 << (level - k);
+        int x1 = min((x + 1) * scale, texture.levelPages[k][0]);
+        int y1 = min((y + 1) * scale, texture.levelPages[k][1]);
+        for (int py = y * scale; py < y1; py++)
+            for (int px = x * scale; px < x1; px++) {
+                uint32_t& e = entry(texture, k, px, py);
+                if (entryLevel(e) > level)
+                    e = value;
+            }
+    }
+    texture.dirty = true;
+}
+
+// As entradas que apontavam para a página passam a usar a do nível acima
+// (que já é o melhor ancestral residente)
+void VirtualTextureSystem::unmapPage(Texture& texture, int level, int x, int y)
+{
+    uint32_t parent = level + 1 < texture.levelCount ? entry(texture, level + 1, x / 2, y / 2) : 0;
+    for (int k = level; k >= 0; k--) {
+        int scale = 1 << (level - k);
+        int x1 = min((x + 1) * scale, texture.levelPages[k][0]);
+        int y1 = min((y + 1) * scale, texture.levelPages[k][1]);
+        for (int py = y * scale; py < y1; py++)
+            for (int px = x * scale; px < x1; px++) {
+                uint32_t& e = entry(texture, k, px, py);
+                if (entryLevel(e) == level)
+                    e = parent;
+            }
+    }
+    texture.dirty = true;
+}
+
+// Copia a página do nível mapeado para a posição `slot` do cache, com a
+// borda tirada dos vizinhos (repetindo a textura nas bordas, como GL_REPEAT)
+void VirtualTextureSystem::uploadPage(Texture& texture, int id, int level, int x, int y, int slot)
+{
+    const TextureLevel& source = texture.source->levels[level];
+    const uint8_t* pixels = texture.source->data + source.offset;
+    int width = (int)source.width, height = (int)source.height;
+
+    int columns[VT_PAGE_SIZE];
+    for (int px = 0; px < VT_PAGE_SIZE; px++)
+        columns[px] = wrap(x * VT_PAGE_CONTENT - VT_PAGE_BORDER + px, width) * 4;
+    for (int py = 0; py < VT_PAGE_SIZE; py++) {
+        const uint8_t* row = pixels + (size_t)wrap(y * VT_PAGE_CONTENT - VT_PAGE_BORDER + py, height) * width * 4;
+        uint8_t* out = &pageBuffer[(size_t)py * VT_PAGE_SIZE * 4];
+        for (int px = 0; px < VT_PAGE_SIZE; px++)
+            memcpy(out + px * 4, row + columns[px], 4);
+    }
+
+    int slotX = slot % cachePages, slotY = slot / cachePages;
+    glBindTexture(GL_TEXTURE_2D, cache);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, slotX * VT_PAGE_SIZE, slotY * VT_PAGE_SIZE, VT_PAGE_SIZE, VT_PAGE_SIZE, GL_RGBA,
+                    GL_UNSIGNED_BYTE, pageBuffer.data());
+
+    slots[slot].page = pageKey(id, level, x, y);
+    slots[slot].used = true;
+    resident[slots[slot].page] = slot;
+    mapPage(texture, level, x, y, packEntry(slotX, slotY, level));
+}
+
+void VirtualTextureSystem::releasePages(int id)
+{
+    for (size_t slot = 0; slot < slots.size(); slot++) {
+        if (!slots[slot].used || (int)(slots[slot].page >> 48) != id)
+            continue;
+        resident.erase(slots[slot].page);
+        if (!slots[slot].pinned)
+            lru.erase(slots[slot].lruPos);
+        slots[slot] = Slot();
+        freeSlots.push_back((int)slot);
+    }
+}
+
+int VirtualTextureSystem::addTexture(const string& path, shared_ptr<PreparedTexture> source)
+{
+    if (!source || source->format != TEXTURE_RGBA8 || source->levels.empty()) {
+        cout << "Textura virtual precisa de um .ctex RGBA8: " << path << endl;
+        return -1;
+    }
+
+    auto found = byPath.find(path);
+    int id = found != byPath.end() ? found->second : (int)textures.size();
+    if (found == byPath.end()) {
+        textures.emplace_back();
+        byPath[path] = id;
+    }
+    else
+        releasePages(id);
+
+    Texture& texture = textures[id];
+    texture.path = path;
+    texture.source = source;
+    texture.levelCount = 0;
+    int rows = 0;
+    for (size_t level = 0; level < source->levels.size() && level < (size_t)VT_MAX_LEVELS; level++) {
+        int pagesX = ((int)source->levels[level].width + VT_PAGE_CONTENT - 1) / VT_PAGE_CONTENT;
+        int pagesY = ((int)source->levels[level].height + VT_PAGE_CONTENT - 1) / VT_PAGE_CONTENT;
+        texture.levelPages[level][0] = pagesX;
+        texture.levelPages[level][1] = pagesY;
+        texture.levelRows[level] = rows;
+        rows += pagesY;
+        texture.levelCount = (int)level + 1;
+        if (pagesX == 1 && pagesY == 1)
+            break;
+    }
+    texture.table.assign((size_t)texture.levelPages[0][0] * rows, 0);
+
+    if (!texture.indirection)
+        glGenTextures(1, &texture.indirection);
+    glBindTexture(GL_TEXTURE_2D, texture.indirection);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture.levelPages[0][0], rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // A página mais grossa cobre a textura inteira e nunca sai do cache
+    if (freeSlots.empty() && !lru.empty()) {
+        int victim = lru.front();
+        PageKey page = slots[victim].page;
+        unmapPage(textures[page >> 48], (int)(page >> 40 & 0xFF), (int)(page >> 20 & 0xFFFFF), (int)(page & 0xFFFFF));
+        resident.erase(page);
+        lru.pop_front();
+        slots[victim] = Slot();
+        freeSlots.push_back(victim);
+    }
+    if (freeSlots.empty()) {
+        cout << "Cache de texturas virtuais cheio de páginas fixas: " << path << endl;
+        return id;
+    }
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    uploadPage(texture, id, texture.levelCount - 1, 0, 0, slot);
+    slots[slot].pinned = true;
+
+    cout << "Textura virtual " << id << ": " << path << " (" << source->width << "x" << source->height << ", "
+         << texture.levelCount << " níveis com páginas, " << texture.levelPages[0][0] * texture.levelPages[0][1]
+         << " páginas no nível 0)" << endl;
+    return id;
+}
+
+int VirtualTextureSystem::find(const string& path) const
+{
+    auto found = byPath.find(path);
+    return found != byPath.end() ? found->second : -1;
+}
+
+void VirtualTextureSystem::setUniforms(GLuint shaderID, int id, GLenum indirectionUnit) const
+{
+    GLint pages[VT_MAX_LEVELS * 2] = {};
+    GLint rows[VT_MAX_LEVELS] = {};
+    const Texture* texture = id >= 0 && id < (int)textures.size() ? &textures[id] : nullptr;
+    if (texture) {
+        memcpy(pages, texture->levelPages, sizeof(pages));
+        memcpy(rows, texture->levelRows, sizeof(rows));
+    }
+    glUniform2f(glGetUniformLocation(shaderID, "vtSize"), texture ? (float)texture->source->width : 0.0f,
+                texture ? (float)texture->source->height : 0.0f);
+    glUniform1i(glGetUniformLocation(shaderID, "vtLevels"), texture ? texture->levelCount : 1);
+    glUniform2iv(glGetUniformLocation(shaderID, "vtLevelPages"), VT_MAX_LEVELS, pages);
+    glUniform1iv(glGetUniformLocation(shaderID, "vtLevelRows"), VT_MAX_LEVELS, rows);
+    glUniform1i(glGetUniformLocation(shaderID, "vtTexture"), id);
+    glUniform1f(glGetUniformLocation(shaderID, "vtCachePages"), (float)cachePages);
+
+    glActiveTexture(indirectionUnit);
+    glBindTexture(GL_TEXTURE_2D, texture ? texture->indirection : 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VirtualTextureSystem::beginFeedback()
+{
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &savedFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, feedbackFbo);
+    glViewport(0, 0, feedbackWidth, feedbackHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void VirtualTextureSystem::endFeedback()
+{
+    // Leitura para o PBO livre; se os dois ainda estão em voo, este quadro fica sem feedback
+    int index = readbackNext;
+    if (!readbackFence[index]) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback[index]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readbackFence[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readbackNext = 1 - index;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, savedFbo);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+VirtualTextureStats VirtualTextureSystem::update()
+{
+    VirtualTextureStats stats;
+
+    // Feedback pronto: a leitura mais antiga primeiro; nunca espera a GPU
+    unordered_set<PageKey> requested;
+    for (int i = 0; i < 2; i++) {
+        int index = (readbackNext + i) % 2;
+        GLsync& fence = readbackFence[index];
+        if (!fence)
+            continue;
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback[index]);
+        size_t bytes = (size_t)feedbackWidth * feedbackHeight * 4;
+        const uint8_t* pixels =
+            static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+        if (pixels) {
+            for (size_t p = 0; p < bytes; p += 4) {
+                int id = pixels[p + 3] - 1;
+                if (id < 0 || id >= (int)textures.size())
+                    continue;
+                const Texture& texture = textures[id];
+                int level = pixels[p + 2], x = pixels[p], y = pixels[p + 1];
+                if (level >= texture.levelCount || x >= texture.levelPages[level][0] ||
+                    y >= texture.levelPages[level][1])
+                    continue;
+                // Os ancestrais também: mantê-los residentes garante um substituto próximo
+                for (; level < texture.levelCount; level++, x /= 2, y /= 2)
+                    if (!requested.insert(pageKey(id, level, x, y)).second)
+                        break;
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    stats.requested = requested.size();
+
+    // Residentes pedidas vão para o fim da LRU; as que faltam entram das mais
+    // grossas para as mais finas, para o substituto melhorar a cada quadro
+    vector<PageKey> missing;
+    for (PageKey page : requested) {
+        auto found = resident.find(page);
+        if (found == resident.end())
+            missing.push_back(page);
+        else if (!slots[found->second].pinned)
+            lru.splice(lru.end(), lru, slots[found->second].lruPos);
+    }
+    sort(missing.begin(), missing.end(), [](PageKey a, PageKey b) { return (a >> 40 & 0xFF) > (b >> 40 & 0xFF); });
+
+    GLint boundTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (PageKey page : missing) {
+        if ((int)stats.uploaded >= pagesPerFrame)
+            break;
+        int slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            // A menos usada, desde que não seja uma das pedidas agora (cache pequeno demais para a cena)
+            if (lru.empty() || requested.count(slots[lru.front()].page))
+                break;
+            slot = lru.front();
+            lru.pop_front();
+            PageKey victim = slots[slot].page;
+            unmapPage(textures[victim >> 48], (int)(victim >> 40 & 0xFF), (int)(victim >> 20 & 0xFFFFF),
+                      (int)(victim & 0xFFFFF));
+            resident.erase(victim);
+            slots[slot] = Slot();
+            stats.evicted++;
+        }
+        int id = (int)(page >> 48);
+        uploadPage(textures[id], id, (int)(page >> 40 & 0xFF), (int)(page >> 20 & 0xFFFFF), (int)(page & 0xFFFFF),
+                   slot);
+        slots[slot].lruPos = lru.insert(lru.end(), slot);
+        stats.uploaded++;
+    }
+    stats.missing = missing.size() - stats.uploaded;
+
+    for (Texture& texture : textures) {
+        if (!texture.dirty)
+            continue;
+        glBindTexture(GL_TEXTURE_2D, texture.indirection);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.levelPages[0][0],
+                        (GLsizei)(texture.table.size() / texture.levelPages[0][0]), GL_RGBA, GL_UNSIGNED_BYTE,
+                        texture.table.data());
+        texture.dirty = false;
+    }
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+    return stats;
+}
+
+const string& virtualTextureGLSL()
+{
+    static const string source = R"(
+// Amostragem de texturas virtuais (ver VirtualTexture.h)
+uniform sampler2D vtCache;
+uniform sampler2D vtIndirection;
+uniform vec2 vtSize;            // texels no nível 0; zero = material sem textura virtual
+uniform int vtLevels;
+uniform ivec2 vtLevelPages[VT_MAX_LEVELS];
+uniform int vtLevelRows[VT_MAX_LEVELS];
+uniform float vtCachePages;
+
+vec2 virtualLevelSize(int level)
+{
+    return max(floor(vtSize / exp2(float(level))), vec2(1.0));
+}
+
+// Nível desejado pelas derivadas (antes do fract, que quebraria as derivadas na emenda)
+int virtualLevel(vec2 uv, float bias)
+{
+    vec2 dx = dFdx(uv * vtSize), dy = dFdy(uv * vtSize);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + bias;
+    return int(clamp(floor(lod), 0.0, float(vtLevels - 1)));
+}
+
+ivec2 virtualPage(vec2 uv, int level)
+{
+    ivec2 page = ivec2(floor(fract(uv) * virtualLevelSize(level) / VT_PAGE_CONTENT));
+    return min(page, vtLevelPages[level] - 1);
+}
+
+vec4 sampleVirtual(vec2 uv)
+{
+    if (vtSize.x == 0.0)
+        return vec4(0.63, 0.63, 0.63, 1.0); // textura ainda não carregada
+    int level = virtualLevel(uv, 0.0);
+    ivec2 page = virtualPage(uv, level);
+    vec4 entry = texelFetch(vtIndirection, ivec2(page.x, vtLevelRows[level] + page.y), 0);
+    int resident = int(entry.b * 255.0 + 0.5);
+    vec2 slot = floor(entry.rg * 255.0 + 0.5);
+
+    // Posição dentro da página residente, que pode ser de um nível mais grosso
+    vec2 texel = fract(uv) * virtualLevelSize(resident);
+    vec2 inPage = texel - floor(texel / VT_PAGE_CONTENT) * VT_PAGE_CONTENT;
+    vec2 cacheUV = (slot * VT_PAGE_SIZE + VT_PAGE_BORDER + inPage) / (vtCachePages * VT_PAGE_SIZE);
+    return textureLod(vtCache, cacheUV, 0.0);
+}
+
+// Feedback: página e nível que este pixel quer, textura + 1 no alfa
+vec4 virtualFeedback(vec2 uv, int textureId, float bias)
+{
+    if (vtSize.x == 0.0)
+        return vec4(0.0);
+    int level = virtualLevel(uv, bias);
+    ivec2 page = virtualPage(uv, level);
+    return vec4(page.x, page.y, level, textureId + 1) / 255.0;
+}
+)";
+    static const string withConstants = "#define VT_MAX_LEVELS " + to_string(VT_MAX_LEVELS) +
+                                        "\n#define VT_PAGE_SIZE " + to_string(VT_PAGE_SIZE) + ".0" +
+                                        "\n#define VT_PAGE_BORDER " + to_string(VT_PAGE_BORDER) + ".0" +
+                                        "\n#define VT_PAGE_CONTENT " + to_string(VT_PAGE_CONTENT) + ".0" + source;
+    return withConstants;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "TextureContainer.h"
+
+// Texturas virtuais: cada textura (um .ctex RGBA8 mapeado, com todos os
+// mips) é dividida em páginas de VT_PAGE_CONTENT x VT_PAGE_CONTENT texels por
+// nível, e só as páginas vistas ficam na GPU, em um cache de tamanho fixo.
+//
+// A cada quadro uma passada de feedback em baixa resolução grava, por pixel,
+// textura, nível e página desejados (ver VT_FEEDBACK_*); a leitura volta por
+// um PBO com fence, sem esperar a GPU, e as páginas pedidas são copiadas do
+// arquivo mapeado para o cache (no máximo `pagesPerFrame` por quadro, as mais
+// grossas primeiro), despejando as usadas há mais tempo. A tabela de
+// indireção de cada textura diz, para cada página de cada nível, onde está no
+// cache a página residente mais próxima (ela mesma ou um ancestral); a página
+// que cobre a textura inteira fica sempre residente, então sempre há o que
+// amostrar. A memória de textura é a do cache, qualquer que seja o tamanho
+// das texturas.
+//
+// O shader calcula o nível pelas derivadas de texCoord * vtSize, lê a entrada
+// da tabela (vtIndirection; os níveis ficam empilhados, o nível n começa na
+// linha vtLevelRows[n] e tem vtLevelPages[n] páginas) e amostra o cache
+// (vtCache) no nível da página residente. Cada página guarda VT_PAGE_BORDER
+// texels dos vizinhos em volta, para o filtro bilinear não cruzar páginas.
+
+const int VT_PAGE_SIZE = 128;  // texels por página no cache, com a borda
+const int VT_PAGE_BORDER = 4;
+const int VT_PAGE_CONTENT = VT_PAGE_SIZE - 2 * VT_PAGE_BORDER;
+const int VT_MAX_LEVELS = 16;
+
+// Feedback (RGBA8): R, G = página no nível, B = nível, A = textura + 1 (0 = vazio)
+const int VT_FEEDBACK_DIVISOR = 8; // a passada tem 1/8 da resolução da janela
+
+// Quanto o sistema fez em um quadro
+struct VirtualTextureStats
+{
+    size_t requested = 0; // páginas distintas no feedback
+    size_t uploaded = 0;  // páginas copiadas para o cache
+    size_t evicted = 0;   // páginas despejadas para dar lugar
+    size_t missing = 0;   // pedidas e ainda não residentes no fim do quadro
+};
+
+struct VirtualTextureSystem
+{
+    int cachePages = 16;    // o cache tem cachePages x cachePages páginas
+    int pagesPerFrame = 16; // envios por quadro, para não travar o quadro
+
+    VirtualTextureSystem() = default;
+    ~VirtualTextureSystem();
+
+    VirtualTextureSystem(const VirtualTextureSystem&) = delete;
+    VirtualTextureSystem& operator=(const VirtualTextureSystem&) = delete;
+
+    // Cria o cache, o framebuffer de feedback (width/VT_FEEDBACK_DIVISOR x
+    // height/VT_FEEDBACK_DIVISOR) e os PBOs de leitura; na thread do GL
+    void create(int width, int height);
+    void destroy();
+
+    // Registra (ou substitui, no recarregamento) a textura de `path`, que
+    // precisa estar em RGBA8; descarta as páginas antigas e deixa residente
+    // só a página mais grossa. Retorna o índice usado pelos shaders.
+    int addTexture(const std::string& path, std::shared_ptr<PreparedTexture> texture);
+    int find(const std::string& path) const;
+
+    // Uniforms de amostragem da textura `id` (-1 = nenhuma: vtSize zero) e a
+    // tabela dela na unidade de textura `indirectionUnit`
+    void setUniforms(GLuint shaderID, int id, GLenum indirectionUnit) const;
+
+    // Passada de feedback: vincula e limpa o framebuffer pequeno; o chamador
+    // desenha a cena com o shader de feedback e chama endFeedback, que
+    // restaura framebuffer e viewport e pede a leitura assíncrona
+    void beginFeedback();
+    void endFeedback();
+
+    // Lê o feedback que já chegou, envia páginas e atualiza as tabelas
+    VirtualTextureStats update();
+
+    GLuint cacheTexture() const { return cache; }
+    size_t residentPages() const { return resident.size(); }
+    size_t cacheBytes() const { return (size_t)cachePages * cachePages * VT_PAGE_SIZE * VT_PAGE_SIZE * 4; }
+
+private:
+    struct Texture
+    {
+        std::string path;
+        std::shared_ptr<PreparedTexture> source;
+        int levelCount = 0; // níveis com páginas, até o primeiro que cabe em uma página
+        int levelPages[VT_MAX_LEVELS][2] = {};
+        int levelRows[VT_MAX_LEVELS] = {};
+        std::vector<uint32_t> table; // entrada de cada página, níveis empilhados como na GPU
+        GLuint indirection = 0;
+        bool dirty = false;
+    };
+
+    // Página virtual: textura, nível, x, y
+    typedef uint64_t PageKey;
+    static PageKey pageKey(int texture, int level, int x, int y);
+
+    struct Slot
+    {
+        PageKey page = 0;
+        bool used = false;
+        bool pinned = false;                // a página mais grossa de uma textura, fora da LRU
+        std::list<int>::iterator lruPos;
+    };
+
+    void uploadPage(Texture& texture, int id, int level, int x, int y, int slot);
+    void mapPage(Texture& texture, int level, int x, int y, uint32_t entry);
+    void unmapPage(Texture& texture, int level, int x, int y);
+    uint32_t& entry(Texture& texture, int level, int x, int y);
+    void releasePages(int id);
+
+    std::vector<Texture> textures;
+    std::map<std::string, int> byPath;
+
+    GLuint cache = 0;
+    std::vector<Slot> slots;                                             // ocupante de cada posição do cache
+    std::list<int> lru;                         // posições não fixas, usadas há menos tempo primeiro
+    std::unordered_map<PageKey, int> resident;  // página -> posição
+    std::vector<int> freeSlots;
+
+    GLuint feedbackFbo = 0, feedbackColor = 0, feedbackDepth = 0;
+    int feedbackWidth = 0, feedbackHeight = 0;
+    GLint savedViewport[4] = {};
+    GLint savedFbo = 0;
+    GLuint readback[2] = {};
+    GLsync readbackFence[2] = {};
+    int readbackNext = 0;
+    std::vector<uint8_t> pageBuffer;
+};
+
+// Funções GLSL (sem #version) para os fragment shaders: sampleVirtual(uv)
+// amostra a textura dos uniforms de setUniforms; virtualFeedback(uv, id,
+// bias) dá a cor da passada de feedback, com bias = -log2(VT_FEEDBACK_DIVISOR)
+const std::string& virtualTextureGLSL();
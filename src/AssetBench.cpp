@@ -0,0 +1,720 @@
+// Ferramenta de linha de comando para medir o carregamento de assets sem abrir janela.
+//
+// Uso:
+//   AssetBench obj <arquivo.obj> [threads...]
+//   AssetBench mesh <arquivo.obj>...
+//   AssetBench model <arquivo.obj>
+//   AssetBench textures <imagem>... [-t threads...]
+//   AssetBench compress <imagem>... [-t threads...]
+//   AssetBench convert [-rgba] [-kaiser] <imagem>...
+//   AssetBench mips <imagem>... [-t threads...]
+//   AssetBench upload <imagem>...
+//   AssetBench residency <orçamento MB> <imagem>...
+//
+// obj: mede a leitura do OBJ com cada quantidade de threads informada (padrão:
+// 1, 2, 4, ... até o número de núcleos) e confere se o resultado é idêntico ao serial.
+// mesh: monta e otimiza a malha indexada de cada arquivo, imprimindo ACMR/ATVR,
+// a cadeia de LOD (triângulos e erro por nível), a fração de triângulos que o
+// cone dos meshlets descarta vista de 26 direções e o tamanho e o erro máximo
+// de cada formato de vértice compacto.
+// model: carrega o OBJ, os .mtl e as texturas map_Kd em série e depois com o
+// pipeline do AssetLoader (MTL e texturas disparados durante a leitura do OBJ),
+// comparando o tempo total com a soma e com o maior dos dois estágios.
+// textures: prepara as imagens pelo TextureCache (decodificação, mips e
+// compressão, sem usar nem gravar o .ctex) com cada quantidade de threads,
+// imprimindo o tempo total e a vazão (MB/s) de cada thread; caminhos
+// repetidos são preparados uma vez só.
+// compress: comprime cada imagem em BC1/BC3/BC5 com todos os mips, com cada
+// quantidade de threads, imprimindo a vazão, a memória economizada em relação
+// a RGBA8 e o erro (PSNR) do primeiro nível.
+// convert: gera (ou confere) o .ctex de cada imagem, em BC1/BC3 ou, com
+// -rgba, em RGBA8, e compara a carga pelo .ctex com a decodificação da imagem
+// mais a geração dos mips e com a simples leitura do arquivo; -kaiser gera os
+// mips com o filtro de Kaiser em vez do de caixa.
+// mips: gera a cadeia de mips de cada imagem na CPU com o filtro de caixa
+// (sem conversão sRGB e em espaço linear) e com o de Kaiser, com cada
+// quantidade de threads, e compara com glGenerateMipmap em um contexto GL
+// invisível, quando houver um.
+// upload: envia cada imagem em RGBA8 pelo UploadScheduler, em quadros
+// simulados, lendo direto da memória e pelo anel de PBOs, e imprime o tempo
+// de CPU por MB gasto nas faixas de textura e os quadros com os PBOs ocupados.
+// residency: carrega as imagens (do .ctex) pelo TextureResidency com o
+// orçamento dado e simula uma câmera passando por elas em fila, uma de cada
+// vez mais próxima; imprime os níveis liberados e restaurados, a maior
+// ocupação, o pior quadro de update e a ocupação final de cada textura.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <thread>
+
+using namespace std;
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "AssetLoader.h"
+#include "Material.h"
+#include "MipGenerator.h"
+#include "ObjLoader.h"
+#include "PixelUploadRing.h"
+#include "TextureCompression.h"
+#include "TextureContainer.h"
+#include "TextureResidency.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "UploadScheduler.h"
+
+using namespace glm;
+
+// Melhor tempo de algumas repetições, para reduzir o ruído
+const int REPETITIONS = 3;
+
+template <typename T>
+bool sameBytes(const vector<T>& a, const vector<T>& b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+bool sameOBJ(const ObjData& a, const ObjData& b)
+{
+    return sameBytes(a.positions, b.positions) && sameBytes(a.colors, b.colors) && sameBytes(a.uvs, b.uvs) &&
+           sameBytes(a.normals, b.normals) && sameBytes(a.corners, b.corners) && sameBytes(a.groups, b.groups) &&
+           a.materials == b.materials && a.objects == b.objects && a.materialLibs == b.materialLibs;
+}
+
+int benchOBJ(const char* path, vector<unsigned> threadCounts)
+{
+    if (threadCounts.empty()) {
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        for (unsigned t = 1; t < cores; t *= 2)
+            threadCounts.push_back(t);
+        threadCounts.push_back(cores);
+    }
+
+    ObjLoadOptions options;
+    options.printStats = false;
+    options.threads = 1;
+
+    ObjData reference;
+    if (!parseOBJ(path, reference, options))
+        return 1;
+
+    cout << path << ": " << reference.positions.size() << " vértices, "
+         << reference.corners.size() / 3 << " triângulos" << endl;
+
+    double serialMs = 0.0;
+    for (unsigned threads : threadCounts) {
+        options.threads = threads;
+        double best = 0.0;
+        bool identical = true;
+        for (int r = 0; r < REPETITIONS; r++) {
+            ObjData obj;
+            auto start = chrono::steady_clock::now();
+            if (!parseOBJ(path, obj, options))
+                return 1;
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            best = r == 0 ? ms : min(best, ms);
+            identical = identical && sameOBJ(obj, reference);
+        }
+        if (threads == 1)
+            serialMs = best;
+
+        cout << "  " << threads << " thread(s): " << best << " ms";
+        if (serialMs > 0.0)
+            cout << " (speedup " << serialMs / best << "x)";
+        cout << (identical ? "" : " RESULTADO DIFERENTE DO SERIAL!") << endl;
+        if (!identical)
+            return 1;
+    }
+    return 0;
+}
+
+// Câmera afastada em cada uma das 26 direções da grade 3x3x3; o frustum cobre a
+// malha inteira, então só o cone de normais descarta
+void benchConeCulling(const IndexedMesh& mesh)
+{
+    GpuMesh gpu;
+    gpu.ranges = mesh.ranges;
+    gpu.meshlets = mesh.meshlets;
+
+    vec3 center = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+    float size = length(mesh.boundsMax - mesh.boundsMin);
+    mat4 fitAll(1.0f);
+    for (int k = 0; k < 3; k++) {
+        fitAll[k][k] = 1.0f / size;
+        fitAll[3][k] = -center[k] / size;
+    }
+
+    MeshletDrawList list;
+    size_t views = 0, triangles = 0, culled = 0;
+    for (int x = -1; x <= 1; x++)
+        for (int y = -1; y <= 1; y++)
+            for (int z = -1; z <= 1; z++) {
+                if (x == 0 && y == 0 && z == 0)
+                    continue;
+                vec3 camera = center + normalize(vec3((float)x, (float)y, (float)z)) * (size * 3.0f);
+                cullMeshlets(gpu, fitAll, camera, list);
+                triangles += list.stats.triangles;
+                culled += list.stats.triangles - list.stats.visibleTriangles;
+                views++;
+            }
+
+    cout << "Descarte por cone (" << views << " direções): " << 100.0 * culled / max<size_t>(triangles, 1)
+         << "% dos triângulos em média" << endl;
+}
+
+int benchMesh(const vector<const char*>& paths)
+{
+    for (const char* path : paths) {
+        ObjData obj;
+        if (!parseOBJ(path, obj))
+            return 1;
+
+        IndexedMesh mesh;
+        buildIndexedMesh(obj, mesh);
+        // ACMR e overdraw só depois dos meshlets, que reordenam os triângulos de novo
+        MeshOrderStats orderBefore = analyzeMeshOrder(mesh);
+        reorderMesh(mesh);
+        buildMeshlets(mesh, path);
+        printMeshOrderStats(path, orderBefore, analyzeMeshOrder(mesh));
+        if (!mesh.meshlets.empty())
+            benchConeCulling(mesh);
+
+        auto start = chrono::steady_clock::now();
+        buildLodChain(mesh, path);
+        cout << "Cadeia de LOD gerada em "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+
+        vector<uint8_t> encoded;
+        Dequantization dequant;
+        cout << "Formato compacto:" << endl;
+        encodeMesh(mesh, VERTEX_FORMAT_COMPACT, encoded, dequant);
+        cout << "Formato preciso:" << endl;
+        encodeMesh(mesh, VERTEX_FORMAT_PRECISE, encoded, dequant);
+    }
+    return 0;
+}
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int benchModel(const char* path)
+{
+    filesystem::path directory = filesystem::path(path).parent_path();
+    ObjLoadOptions options;
+    options.printStats = false;
+
+    // Texturas convertidas como na primeira carga de um programa, sem o .ctex,
+    // para que a série e o pipeline façam o mesmo trabalho
+    TextureBuildOptions textureOptions;
+    textureOptions.container = false;
+
+    // Série: OBJ, depois cada .mtl, depois cada textura
+    auto start = chrono::steady_clock::now();
+    ObjData obj;
+    if (!parseOBJ(path, obj, options))
+        return 1;
+    double parseMs = elapsedMs(start);
+
+    auto decodeStart = chrono::steady_clock::now();
+    set<string> maps;
+    size_t materialCount = 0, textureBytes = 0;
+    for (const string& library : obj.materialLibs) {
+        vector<Material> materials;
+        loadMTL((directory / library).string().c_str(), materials);
+        materialCount += materials.size();
+        for (const Material& material : materials) {
+            if (material.diffuseMap.empty() || !maps.insert(material.diffuseMap).second)
+                continue;
+            PreparedTexture texture;
+            if (prepareTexture(material.diffuseMap, texture, textureOptions))
+                textureBytes += texture.storedBytes();
+        }
+    }
+    double decodeMs = elapsedMs(decodeStart);
+    double serialMs = elapsedMs(start);
+
+    // Pipeline: o mtllib dispara o .mtl e as texturas enquanto o OBJ ainda é lido
+    size_t pipelinedTextures = 0;
+    start = chrono::steady_clock::now();
+    {
+        AssetLoader loader;
+        TextureCache textures(loader, textureOptions);
+        ObjData pipelined;
+        options.onMaterialLibrary = [&](const string& library) {
+            loadMaterialsAsync(
+                loader, (directory / library).string(), [](const string&, vector<Material>&) {}, &textures,
+                [&](shared_ptr<PreparedTexture> texture) {
+                    if (texture)
+                        pipelinedTextures++;
+                });
+        };
+        if (!parseOBJ(path, pipelined, options))
+            return 1;
+        while (loader.pending() > 0) {
+            if (loader.poll() == 0)
+                this_thread::sleep_for(chrono::microseconds(100));
+        }
+    }
+    double pipelinedMs = elapsedMs(start);
+
+    cout << path << ": " << obj.corners.size() / 3 << " triângulos, " << materialCount << " materiais, "
+         << maps.size() << " texturas (" << textureBytes / (1024.0 * 1024.0) << " MB preparados)" << endl;
+    cout << "  Série: OBJ " << parseMs << " ms + MTL/texturas " << decodeMs << " ms = " << serialMs << " ms"
+         << endl;
+    cout << "  Pipeline: " << pipelinedMs << " ms (" << pipelinedTextures << " texturas; limite max(OBJ, texturas) = "
+         << max(parseMs, decodeMs) << " ms, speedup " << serialMs / pipelinedMs << "x)" << endl;
+    return 0;
+}
+
+int benchTextures(const vector<string>& paths, vector<unsigned> threadCounts)
+{
+    if (threadCounts.empty()) {
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        for (unsigned t = 1; t < cores; t *= 2)
+            threadCounts.push_back(t);
+        threadCounts.push_back(cores);
+    }
+
+    // Sem o .ctex, para toda rodada converter de novo; mips e compressão em
+    // uma thread, para a vazão depender só das threads do AssetLoader
+    TextureBuildOptions options;
+    options.container = false;
+    options.mips.threads = 1;
+
+    for (unsigned threads : threadCounts) {
+        AssetLoader loader(threads);
+        TextureCache textures(loader, options);
+        size_t delivered = 0, bytes = 0;
+
+        auto start = chrono::steady_clock::now();
+        for (const string& path : paths)
+            textures.request(path, [&](shared_ptr<PreparedTexture> texture) {
+                if (!texture)
+                    return;
+                delivered++;
+                bytes += texture->uncompressedBytes();
+            });
+        while (loader.pending() > 0) {
+            if (loader.poll() == 0)
+                this_thread::sleep_for(chrono::microseconds(100));
+        }
+        double ms = elapsedMs(start);
+
+        cout << threads << " thread(s): " << delivered << " de " << paths.size() << " imagens em " << ms << " ms ("
+             << bytes / (1024.0 * 1024.0) / (ms / 1000.0) << " MB/s entregues)" << endl;
+        textures.printStats();
+    }
+    return 0;
+}
+
+// PSNR dos canais usados pelo formato (RGB, RGBA ou RG)
+double levelPsnr(TextureFormat format, const uint8_t* original, const uint8_t* decoded, size_t pixels)
+{
+    int channels = format == TEXTURE_BC1 ? 3 : format == TEXTURE_BC3 ? 4 : 2;
+    double sum = 0.0;
+    for (size_t i = 0; i < pixels; i++)
+        for (int c = 0; c < channels; c++) {
+            double d = (double)original[i * 4 + c] - decoded[i * 4 + c];
+            sum += d * d;
+        }
+    double mse = sum / ((double)pixels * channels);
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+int benchCompression(const vector<string>& paths, vector<unsigned> threadCounts)
+{
+    if (threadCounts.empty()) {
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        for (unsigned t = 1; t < cores; t *= 2)
+            threadCounts.push_back(t);
+        threadCounts.push_back(cores);
+    }
+
+    for (const string& path : paths) {
+        TextureImage image;
+        if (!decodeTexture(path, image, true, 4))
+            return 1;
+
+        const TextureFormat formats[] = { chooseTextureFormat(image), TEXTURE_BC5 };
+        for (TextureFormat format : formats) {
+            vector<TextureLevel> levels;
+            vector<uint8_t> data;
+            double serialMs = 0.0;
+            size_t rgbaBytes = 0;
+            for (unsigned threads : threadCounts) {
+                double best = 0.0;
+                for (int r = 0; r < REPETITIONS; r++) {
+                    auto start = chrono::steady_clock::now();
+                    MipOptions mips;
+                    mips.threads = threads;
+                    compressTexture(image, format, levels, data, mips);
+                    double ms = elapsedMs(start);
+                    best = r == 0 ? ms : min(best, ms);
+                }
+                if (threads == threadCounts.front())
+                    serialMs = best;
+
+                rgbaBytes = 0;
+                for (const TextureLevel& level : levels)
+                    rgbaBytes += (size_t)level.width * level.height * 4;
+                cout << "  " << textureFormatName(format) << ", " << threads << " thread(s): " << best << " ms ("
+                     << rgbaBytes / (1024.0 * 1024.0) / (best / 1000.0) << " MB/s, speedup " << serialMs / best
+                     << "x)" << endl;
+            }
+
+            vector<uint8_t> decoded(image.bytes());
+            decompressLevel(format, data.data(), (uint32_t)image.width, (uint32_t)image.height, decoded.data());
+            cout << "  " << textureFormatName(format) << ": " << levels.size() << " níveis, " << data.size() / 1024.0
+                 << " KB em vez de " << rgbaBytes / 1024.0 << " KB (" << 100.0 * (1.0 - (double)data.size() / rgbaBytes)
+                 << "% menos), PSNR do nível 0 " << levelPsnr(format, image.data, decoded.data(),
+                                                               (size_t)image.width * image.height)
+                 << " dB" << endl;
+        }
+    }
+    return 0;
+}
+
+int convertTextures(const vector<string>& paths, bool compress, MipFilter filter)
+{
+    TextureBuildOptions options;
+    options.compress = compress;
+    options.mips.filter = filter;
+    for (const string& path : paths) {
+        PreparedTexture converted;
+        if (!prepareTexture(path, converted, options))
+            return 1;
+
+        // Antes: PNG decodificado e mips gerados a cada execução
+        auto start = chrono::steady_clock::now();
+        TextureImage image;
+        vector<TextureLevel> levels;
+        vector<uint8_t> data;
+        decodeTexture(path, image, true, 4);
+        compressTexture(image, TEXTURE_RGBA8, levels, data, options.mips);
+        double decodeMs = elapsedMs(start);
+
+        // Agora: .ctex mapeado, com todas as páginas tocadas como no envio
+        start = chrono::steady_clock::now();
+        PreparedTexture loaded;
+        prepareTexture(path, loaded, options);
+        volatile uint8_t touched = 0;
+        for (const TextureLevel& level : loaded.levels)
+            for (uint64_t i = 0; i < level.size; i += 4096)
+                touched = touched + loaded.data[level.offset + i];
+        double containerMs = elapsedMs(start);
+
+        // Referência: leitura do arquivo inteiro para a memória
+        start = chrono::steady_clock::now();
+        ifstream file(textureContainerPath(path), ios::binary | ios::ate);
+        vector<char> bytes((size_t)file.tellg());
+        file.seekg(0);
+        file.read(bytes.data(), bytes.size());
+        double readMs = elapsedMs(start);
+
+        cout << "  " << path << ": PNG + mips " << decodeMs << " ms, .ctex " << containerMs << " ms, leitura de "
+             << bytes.size() / 1024 << " KB " << readMs << " ms" << endl;
+    }
+    return 0;
+}
+
+// Contexto GL 4.0 em uma janela invisível, para medir glGenerateMipmap
+GLFWwindow* createHiddenContext()
+{
+    if (!glfwInit())
+        return nullptr;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "AssetBench", nullptr, nullptr);
+    if (window) {
+        glfwMakeContextCurrent(window);
+        if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+            return window;
+        glfwDestroyWindow(window);
+    }
+    glfwTerminate();
+    return nullptr;
+}
+
+// Tempo de glGenerateMipmap sobre o nível 0 já enviado, com glFinish dos dois
+// lados para contar só a geração (e não o envio)
+double glGenerateMipmapMs(const TextureImage& image)
+{
+    GLuint texID;
+    glGenTextures(1, &texID);
+    glBindTexture(GL_TEXTURE_2D, texID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
+
+    double best = 0.0;
+    for (int r = 0; r < REPETITIONS; r++) {
+        glFinish();
+        auto start = chrono::steady_clock::now();
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+        double ms = elapsedMs(start);
+        best = r == 0 ? ms : min(best, ms);
+    }
+    glDeleteTextures(1, &texID);
+    return best;
+}
+
+int benchMips(const vector<string>& paths, vector<unsigned> threadCounts)
+{
+    if (threadCounts.empty()) {
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        for (unsigned t = 1; t < cores; t *= 2)
+            threadCounts.push_back(t);
+        threadCounts.push_back(cores);
+    }
+
+    GLFWwindow* window = createHiddenContext();
+    if (!window)
+        cout << "Sem contexto OpenGL: glGenerateMipmap não será medido" << endl;
+
+    struct Variant
+    {
+        const char* name;
+        MipFilter filter;
+        bool srgb;
+    };
+    const Variant variants[] = { { "caixa, sem conversão sRGB", MIP_FILTER_BOX, false },
+                                 { "caixa, espaço linear", MIP_FILTER_BOX, true },
+                                 { "Kaiser, espaço linear", MIP_FILTER_KAISER, true } };
+
+    for (const string& path : paths) {
+        TextureImage image;
+        if (!decodeTexture(path, image, true, 4))
+            return 1;
+
+        // A vazão conta os bytes RGBA8 gerados (todos os níveis menos o 0)
+        double mipMB = 0.0;
+        for (const Variant& variant : variants) {
+            double serialMs = 0.0;
+            for (unsigned threads : threadCounts) {
+                MipOptions options;
+                options.filter = variant.filter;
+                options.srgb = variant.srgb;
+                options.threads = threads;
+
+                vector<TextureLevel> levels;
+                vector<uint8_t> data;
+                double best = 0.0;
+                for (int r = 0; r < REPETITIONS; r++) {
+                    auto start = chrono::steady_clock::now();
+                    generateMipChain(image.data, (uint32_t)image.width, (uint32_t)image.height, options, levels, data);
+                    double ms = elapsedMs(start);
+                    best = r == 0 ? ms : min(best, ms);
+                }
+                if (threads == threadCounts.front())
+                    serialMs = best;
+                mipMB = (data.size() - levels[0].size) / (1024.0 * 1024.0);
+                cout << "  " << variant.name << ", " << threads << " thread(s): " << best << " ms ("
+                     << mipMB / (best / 1000.0) << " MB/s, speedup " << serialMs / best << "x)" << endl;
+            }
+        }
+
+        if (window) {
+            double ms = glGenerateMipmapMs(image);
+            cout << "  glGenerateMipmap: " << ms << " ms (" << mipMB / (ms / 1000.0) << " MB/s)" << endl;
+        }
+    }
+
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return 0;
+}
+
+int benchUpload(const vector<string>& paths)
+{
+    GLFWwindow* window = createHiddenContext();
+    if (!window) {
+        cout << "Sem contexto OpenGL: nada a medir" << endl;
+        return 1;
+    }
+
+    for (const string& path : paths) {
+        auto image = make_shared<TextureImage>();
+        if (!decodeTexture(path, *image, true, 4))
+            return 1;
+
+        for (bool usePbo : { false, true }) {
+            PixelUploadRing ring;
+            UploadScheduler scheduler;
+            if (usePbo) {
+                ring.create();
+                scheduler.pixelRing = &ring;
+            }
+
+            GLuint texID = 0;
+            auto start = chrono::steady_clock::now();
+            uploadTextureScheduled(scheduler, image->width, image->height, 4, image->data, image,
+                                   [&texID](GLuint loaded) { texID = loaded; });
+            // Um glFlush por quadro simulado, como faria a troca de buffers
+            while (!scheduler.idle()) {
+                scheduler.update();
+                glFlush();
+            }
+            glFinish();
+            double totalMs = elapsedMs(start);
+
+            double mb = scheduler.total.textureBytes / (1024.0 * 1024.0);
+            cout << "  " << path << (usePbo ? ", por PBO: " : ", direto: ") << scheduler.total.textureMs / mb
+                 << " ms de CPU por MB, " << scheduler.busyFrames << " quadros (" << scheduler.total.ringFullFrames
+                 << " com os PBOs ocupados), pior quadro " << scheduler.worstFrameMs << " ms, " << totalMs
+                 << " ms até a GPU terminar" << endl;
+            glDeleteTextures(1, &texID);
+            ring.destroy();
+        }
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
+
+int benchResidency(size_t budgetMB, const vector<string>& paths)
+{
+    GLFWwindow* window = createHiddenContext();
+    if (!window) {
+        cout << "Sem contexto OpenGL: nada a medir" << endl;
+        return 1;
+    }
+
+    {
+        TextureResidency residency;
+        residency.budgetBytes = budgetMB << 20;
+        vector<GLuint> textures;
+        for (const string& path : paths) {
+            auto texture = make_shared<PreparedTexture>();
+            if (!prepareTexture(path, *texture))
+                return 1;
+            textures.push_back(residency.loadTexture(texture));
+        }
+        cout << "Carregadas: " << residency.residentBytes() / 1024 << " KB na GPU de " << residency.fullBytes() / 1024
+             << " KB com todos os níveis" << endl;
+
+        // A câmera anda ao longo da fila: a textura i está na posição i e só
+        // as até 2 unidades de distância são desenhadas, com 1024 pixels a
+        // uma unidade e menos quanto mais longe
+        const int frames = 300;
+        TextureResidencyStats total;
+        double worstMs = 0.0;
+        size_t peakBytes = residency.residentBytes();
+        for (int frame = 0; frame < frames; frame++) {
+            float camera = (float)frame / frames * textures.size();
+            for (size_t i = 0; i < textures.size(); i++) {
+                float distance = fabs((float)i + 0.5f - camera);
+                if (distance <= 2.0f)
+                    residency.touch(textures[i], 1024.0f / max(distance, 1.0f));
+            }
+            TextureResidencyStats stats = residency.update();
+            glFlush();
+            total.droppedLevels += stats.droppedLevels;
+            total.droppedBytes += stats.droppedBytes;
+            total.restoredLevels += stats.restoredLevels;
+            total.restoredBytes += stats.restoredBytes;
+            worstMs = max(worstMs, stats.ms);
+            peakBytes = max(peakBytes, residency.residentBytes());
+        }
+        glFinish();
+
+        cout << "  " << frames << " quadros: " << total.droppedLevels << " níveis liberados ("
+             << total.droppedBytes / 1024 << " KB), " << total.restoredLevels << " restaurados ("
+             << total.restoredBytes / 1024 << " KB), pico de " << peakBytes / 1024 << " KB (orçamento "
+             << residency.budgetBytes / 1024 << " KB), pior update " << worstMs << " ms, erro GL 0x" << hex
+             << glGetError() << dec << endl;
+        residency.printStats();
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
+
+void printUsage()
+{
+    cout << "Uso:" << endl;
+    cout << "  AssetBench obj <arquivo.obj> [threads...]" << endl;
+    cout << "  AssetBench mesh <arquivo.obj>..." << endl;
+    cout << "  AssetBench model <arquivo.obj>" << endl;
+    cout << "  AssetBench textures <imagem>... [-t threads...]" << endl;
+    cout << "  AssetBench compress <imagem>... [-t threads...]" << endl;
+    cout << "  AssetBench convert [-rgba] [-kaiser] <imagem>..." << endl;
+    cout << "  AssetBench mips <imagem>... [-t threads...]" << endl;
+    cout << "  AssetBench upload <imagem>..." << endl;
+    cout << "  AssetBench residency <orçamento MB> <imagem>..." << endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+
+    string command = argv[1];
+    if (command == "obj") {
+        vector<unsigned> threadCounts;
+        for (int i = 3; i < argc; i++)
+            threadCounts.push_back((unsigned)atoi(argv[i]));
+        return benchOBJ(argv[2], threadCounts);
+    }
+    if (command == "mesh")
+        return benchMesh(vector<const char*>(argv + 2, argv + argc));
+    if (command == "model")
+        return benchModel(argv[2]);
+    if (command == "upload")
+        return benchUpload(vector<string>(argv + 2, argv + argc));
+    if (command == "residency" && argc >= 4)
+        return benchResidency((size_t)atoi(argv[2]), vector<string>(argv + 3, argv + argc));
+    if (command == "convert") {
+        bool compress = true;
+        MipFilter filter = MIP_FILTER_BOX;
+        vector<string> paths;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "-rgba") == 0)
+                compress = false;
+            else if (strcmp(argv[i], "-kaiser") == 0)
+                filter = MIP_FILTER_KAISER;
+            else
+                paths.push_back(argv[i]);
+        }
+        return convertTextures(paths, compress, filter);
+    }
+    if (command == "textures" || command == "compress" || command == "mips") {
+        vector<string> paths;
+        vector<unsigned> threadCounts;
+        bool readingThreads = false;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "-t") == 0)
+                readingThreads = true;
+            else if (readingThreads)
+                threadCounts.push_back((unsigned)atoi(argv[i]));
+            else
+                paths.push_back(argv[i]);
+        }
+        if (command == "compress")
+            return benchCompression(paths, threadCounts);
+        if (command == "mips")
+            return benchMips(paths, threadCounts);
+        return benchTextures(paths, threadCounts);
+    }
+
+    printUsage();
+    return 1;
+}
@@ -18,9 +18,17 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// Carregador de OBJ e malhas indexadas compartilhados (common/)
+#include "ObjLoader.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "AssetLoader.h"
+
+#include <memory>
+
 using namespace glm;
 
 #include <cmath>
@@ -32,11 +40,9 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 int setupShader();
 int setupGeometry();
 GLuint loadTexture(string filePath, int &width, int &height);
-bool loadMTL(const char* path, vec3& ka, vec3& kd, vec3& ks, float& ns);
+void setMaterialUniforms(GLuint shaderID, const Material& material);
 void drawGeometry(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, int nVertices, vec3 color= vec3(1.0,0.0,0.0), vec3 axis = vec3(0.0, 0.0, 1.0));
-GLuint generateSphere(float radius, int latSegments, int lonSegments, int &nVertices);
-bool loadOBJ(const char* path, vector<vec3>& out_vertices, vector<vec2>& out_uvs, vector<vec3>& out_normals);
-GLuint createVAOFromOBJ(const char* objPath, int& nVertices);
+GpuMesh generateSphere(float radius, int latSegments, int lonSegments);
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 800;
@@ -53,17 +59,34 @@ uniform mat4 projection;
 uniform mat4 model;
 uniform mat4 view;
 
+// Dequantização dos vértices compactados (ver setMeshUniforms)
+uniform vec3 posScale = vec3(1.0);
+uniform vec3 posOffset = vec3(0.0);
+uniform vec2 uvScale = vec2(1.0);
+uniform vec2 uvOffset = vec2(0.0);
+uniform bool octNormals = false;
+
 out vec2 texCoord;
 out vec3 fragNormal;
 out vec3 fragPos;
 out vec4 vColor;
 
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0);
-    fragPos = vec3(model * vec4(position, 1.0));
-    fragNormal = mat3(transpose(inverse(model))) * normal;
-    texCoord = texc;
+    vec3 pos = position * posScale + posOffset;
+    vec3 n = octNormals ? decodeOctahedral(normal.xy / 32767.0) : normal;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+    fragPos = vec3(model * vec4(pos, 1.0));
+    fragNormal = mat3(transpose(inverse(model))) * n;
+    texCoord = texc * uvScale + uvOffset;
     vColor = vec4(color, 1.0);
 })";
 
@@ -106,221 +129,60 @@ void main()
     color = vec4(result, 1.0);
 })";
 
-GLuint generateSphere(float radius, int latSegments, int lonSegments, int &nVertices) {
-    vector<GLfloat> vBuffer;
+GpuMesh generateSphere(float radius, int latSegments, int lonSegments) {
+    IndexedMesh mesh;
 
     vec3 color = vec3(1.0f, 0.0f, 0.0f);
 
-    auto calcPosUVNormal = [&](int lat, int lon, vec3& pos, vec2& uv, vec3& normal) {
-        float theta = lat * pi<float>() / latSegments;
-        float phi = lon * 2.0f * pi<float>() / lonSegments;
-
-        pos = vec3(
-            radius * cos(phi) * sin(theta),
-            radius * cos(theta),
-            radius * sin(phi) * sin(theta)
-        );
-
-        uv = vec2(
-            phi / (2.0f * pi<float>()),
-            theta / pi<float>()
-        );
-
-        normal = normalize(pos);
-    };
-
-    for (int i = 0; i < latSegments; ++i) {
-        for (int j = 0; j < lonSegments; ++j) {
-            vec3 v0, v1, v2, v3;
-            vec2 uv0, uv1, uv2, uv3;
-            vec3 n0, n1, n2, n3;
-
-            calcPosUVNormal(i, j, v0, uv0, n0);
-            calcPosUVNormal(i + 1, j, v1, uv1, n1);
-            calcPosUVNormal(i, j + 1, v2, uv2, n2);
-            calcPosUVNormal(i + 1, j + 1, v3, uv3, n3);
-
-            vBuffer.insert(vBuffer.end(), { v0.x, v0.y, v0.z, color.r, color.g, color.b, n0.x, n0.y, n0.z, uv0.x, uv0.y });
-            vBuffer.insert(vBuffer.end(), { v1.x, v1.y, v1.z, color.r, color.g, color.b, n1.x, n1.y, n1.z, uv1.x, uv1.y });
-            vBuffer.insert(vBuffer.end(), { v2.x, v2.y, v2.z, color.r, color.g, color.b, n2.x, n2.y, n2.z, uv2.x, uv2.y });
-
-            vBuffer.insert(vBuffer.end(), { v1.x, v1.y, v1.z, color.r, color.g, color.b, n1.x, n1.y, n1.z, uv1.x, uv1.y });
-            vBuffer.insert(vBuffer.end(), { v3.x, v3.y, v3.z, color.r, color.g, color.b, n3.x, n3.y, n3.z, uv3.x, uv3.y });
-            vBuffer.insert(vBuffer.end(), { v2.x, v2.y, v2.z, color.r, color.g, color.b, n2.x, n2.y, n2.z, uv2.x, uv2.y });
+    // Grade de (latSegments + 1) x (lonSegments + 1) vértices compartilhados
+    mesh.vertices.resize((latSegments + 1) * (lonSegments + 1));
+    for (int i = 0; i <= latSegments; ++i) {
+        for (int j = 0; j <= lonSegments; ++j) {
+            float theta = i * pi<float>() / latSegments;
+            float phi = j * 2.0f * pi<float>() / lonSegments;
+
+            MeshVertex& v = mesh.vertices[i * (lonSegments + 1) + j];
+            v.position = vec3(
+                radius * cos(phi) * sin(theta),
+                radius * cos(theta),
+                radius * sin(phi) * sin(theta)
+            );
+            v.normal = normalize(v.position);
+            v.uv = vec2(
+                phi / (2.0f * pi<float>()),
+                theta / pi<float>()
+            );
         }
     }
 
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vBuffer.size() * sizeof(GLfloat), vBuffer.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(0));
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(2);
-
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(9 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(3);
-
-    glBindVertexArray(0);
-
-    nVertices = vBuffer.size() / 11;
-
-    return VAO;
-}
-
-bool loadOBJ(const char* path, vector<vec3>& out_vertices, vector<vec2>& out_uvs, vector<vec3>& out_normals) {
-    vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-    vector<vec3> temp_vertices;
-    vector<vec2> temp_uvs;
-    vector<vec3> temp_normals;
-
-    FILE* file = fopen(path, "r");
-    if (file == NULL) {
-        printf("Erro ao abrir o arquivo OBJ!\n");
-        return false;
-    }
-
-    while (1) {
-        char lineHeader[128];
-        int res = fscanf(file, "%s", lineHeader);
-        if (res == EOF)
-            break;
+    // Dois triângulos por quadrilátero, em sentido anti-horário vistos de fora
+    mesh.indices.reserve(latSegments * lonSegments * 6);
+    for (int i = 0; i < latSegments; ++i) {
+        for (int j = 0; j < lonSegments; ++j) {
+            uint32_t i0 = i * (lonSegments + 1) + j;
+            uint32_t i1 = (i + 1) * (lonSegments + 1) + j;
+            uint32_t i2 = i0 + 1;
+            uint32_t i3 = i1 + 1;
 
-        if (strcmp(lineHeader, "v") == 0) {
-            vec3 vertex;
-            fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-            temp_vertices.push_back(vertex);
-        }
-        else if (strcmp(lineHeader, "vt") == 0) {
-            vec2 uv;
-            fscanf(file, "%f %f\n", &uv.x, &uv.y);
-            temp_uvs.push_back(uv);
-        }
-        else if (strcmp(lineHeader, "vn") == 0) {
-            vec3 normal;
-            fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-            temp_normals.push_back(normal);
-        }
-        else if (strcmp(lineHeader, "f") == 0) {
-            unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-            int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n",
-                &vertexIndex[0], &uvIndex[0], &normalIndex[0],
-                &vertexIndex[1], &uvIndex[1], &normalIndex[1],
-                &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-
-            if (matches != 9) {
-                printf("Arquivo OBJ não pode ser lido. Tente exportar com outras opções\n");
-                return false;
-            }
-
-            vertexIndices.push_back(vertexIndex[0]);
-            vertexIndices.push_back(vertexIndex[1]);
-            vertexIndices.push_back(vertexIndex[2]);
-            uvIndices.push_back(uvIndex[0]);
-            uvIndices.push_back(uvIndex[1]);
-            uvIndices.push_back(uvIndex[2]);
-            normalIndices.push_back(normalIndex[0]);
-            normalIndices.push_back(normalIndex[1]);
-            normalIndices.push_back(normalIndex[2]);
+            mesh.indices.insert(mesh.indices.end(), { i0, i2, i1 });
+            mesh.indices.insert(mesh.indices.end(), { i1, i2, i3 });
         }
     }
 
-    // Processando os índices
-    for (unsigned int i = 0; i < vertexIndices.size(); i++) {
-        unsigned int vertexIndex = vertexIndices[i];
-        unsigned int uvIndex = uvIndices[i];
-        unsigned int normalIndex = normalIndices[i];
+    // A grade sai linha por linha; reordena para o cache de vértices
+    optimizeMesh(mesh, "esfera procedural");
 
-        vec3 vertex = temp_vertices[vertexIndex - 1];
-        vec2 uv = temp_uvs[uvIndex - 1];
-        vec3 normal = temp_normals[normalIndex - 1];
-
-        out_vertices.push_back(vertex);
-        out_uvs.push_back(uv);
-        out_normals.push_back(normal);
-    }
-
-    fclose(file);
-    return true;
-}
-
-GLuint createVAOFromOBJ(const char* objPath, int& nVertices) {
-    vector<vec3> vertices;
-    vector<vec2> uvs;
-    vector<vec3> normals;
-    vector<GLfloat> vboData;
-
-    if (!loadOBJ(objPath, vertices, uvs, normals)) {
-        return 0;
-    }
-
-    vec3 color(1.0f, 0.0f, 0.0f); // Cor padrão vermelha
-
-    // Montando o VBO com todos os atributos
-    for (size_t i = 0; i < vertices.size(); i++) {
-        // Posição
-        vboData.push_back(vertices[i].x);
-        vboData.push_back(vertices[i].y);
-        vboData.push_back(vertices[i].z);
-        
-        // Cor
-        vboData.push_back(color.r);
-        vboData.push_back(color.g);
-        vboData.push_back(color.b);
-        
-        // Normal
-        vboData.push_back(normals[i].x);
-        vboData.push_back(normals[i].y);
-        vboData.push_back(normals[i].z);
-        
-        // UV
-        vboData.push_back(uvs[i].x);
-        vboData.push_back(uvs[i].y);
-    }
-
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vboData.size() * sizeof(GLfloat), vboData.data(), GL_STATIC_DRAW);
-
-    // Posição (location = 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(0);
-
-    // Cor (location = 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-
-    // Normal (location = 2)
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(2);
-
-    // UV (location = 3)
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(9 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(3);
-
-    glBindVertexArray(0);
-
-    nVertices = vertices.size();
-    return VAO;
+    // Sem cor por vértice: só os fluxos de posição e de normal/UV vão para a GPU
+    GpuMesh gpu = uploadMesh(mesh, VERTEX_FORMAT_COMPACT);
+    gpu.color = color;
+    return gpu;
 }
 
 int main()
 {
+    // Latências de carregamento contadas desde o início do programa
+    LoadTimer loadTimer;
+
     glfwInit();
 
     GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Desafio 4 - Iluminação de Phong", nullptr, nullptr);
@@ -336,12 +198,19 @@ int main()
 
     GLuint shaderID = setupShader();
 
-    int nVertices;
-    GLuint VAO = createVAOFromOBJ("../assets/Modelos3D/sphere.obj", nVertices);
-    if (VAO == 0) {
-        // Se falhar ao carregar o OBJ, usa a esfera gerada proceduralmente
-        VAO = generateSphere(0.5, 50, 50, nVertices);
-    }
+    // A esfera gerada proceduralmente aparece já no primeiro quadro e continua
+    // em uso se o OBJ não carregar. A partir da segunda execução a malha vem
+    // pronta do arquivo .meshcache, já no formato compacto de 16 bytes por vértice
+    AssetLoader loader;
+    UploadScheduler uploads;
+    GpuMesh mesh = generateSphere(0.5, 50, 50);
+    loadMeshAsync(loader, uploads, "../assets/Modelos3D/sphere.obj", vec3(1.0f, 0.0f, 0.0f), VERTEX_FORMAT_COMPACT,
+                  [&](GpuMesh& loaded) {
+                      if (loaded.VAO == 0)
+                          return;
+                      deleteMesh(mesh);
+                      mesh = loaded;
+                  });
 
     glUseProgram(shaderID);
 
@@ -352,21 +221,16 @@ int main()
     glUniform3fv(glGetUniformLocation(shaderID, "lightColor"), 1, value_ptr(lightColor));
     glUniform3fv(glGetUniformLocation(shaderID, "viewPos"), 1, value_ptr(vec3(0.0f, 0.0f, 5.0f)));
 
-    // Carregando coeficientes do material do arquivo MTL
-    vec3 ka, kd, ks;
-    float ns;
-    if (!loadMTL("../assets/materials/sphere.mtl", ka, kd, ks, ns)) {
-        // Se falhar ao carregar o MTL, usa valores padrão
-        ka = vec3(0.2f, 0.2f, 0.2f);
-        kd = vec3(0.7f, 0.7f, 0.7f);
-        ks = vec3(1.0f, 1.0f, 1.0f);
-        ns = 32.0f;
-    }
-
-    glUniform3fv(glGetUniformLocation(shaderID, "Ka"), 1, value_ptr(ka));
-    glUniform3fv(glGetUniformLocation(shaderID, "Kd"), 1, value_ptr(kd));
-    glUniform3fv(glGetUniformLocation(shaderID, "Ks"), 1, value_ptr(ks));
-    glUniform1f(glGetUniformLocation(shaderID, "Ns"), ns);
+    // Coeficientes do material: valores padrão até o arquivo MTL ser lido em
+    // uma thread de trabalho (ou se falhar)
+    Material defaultMaterial;
+    defaultMaterial.kd = vec3(0.7f);
+    defaultMaterial.ns = 32.0f;
+    setMaterialUniforms(shaderID, defaultMaterial);
+    loadMaterialsAsync(loader, "../assets/materials/sphere.mtl", [shaderID](const string&, vector<Material>& library) {
+        if (!library.empty())
+            setMaterialUniforms(shaderID, library[0]);
+    });
 
     mat4 view = lookAt(vec3(0.0f, 0.0f, 5.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
     mat4 projection = perspective(radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
@@ -375,11 +239,18 @@ int main()
     glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
 
     glEnable(GL_DEPTH_TEST);
+    // Malhas opacas e fechadas, frente em sentido anti-horário: as faces de costas
+    // nem chegam ao rasterizador
+    glEnable(GL_CULL_FACE);
 
     while (!glfwWindowShouldClose(window))
     {
         glfwPollEvents();
 
+        // Envia para a GPU o que as threads de trabalho terminaram
+        loader.poll();
+        uploads.update();
+
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -387,14 +258,14 @@ int main()
         model = rotate(model, (float)glfwGetTime(), vec3(0.5f, 1.0f, 0.0f));
         glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
 
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, nVertices);
-        glBindVertexArray(0);
+        setMeshUniforms(shaderID, mesh);
+        drawMesh(mesh);
 
         glfwSwapBuffers(window);
+        loadTimer.frameShown(loader.pending() == 0 && uploads.idle());
     }
 
-    glDeleteVertexArrays(1, &VAO);
+    deleteMesh(mesh);
     glfwTerminate();
     return 0;
 }
@@ -448,39 +319,10 @@ int setupShader()
     return shaderProgram;
 }
 
-bool loadMTL(const char* path, vec3& ka, vec3& kd, vec3& ks, float& ns) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        std::cout << "Erro ao abrir arquivo MTL: " << path << std::endl;
-        return false;
-    }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string token;
-        iss >> token;
-
-        if (token == "Ka") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            ka = vec3(x, y, z);
-        }
-        else if (token == "Kd") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            kd = vec3(x, y, z);
-        }
-        else if (token == "Ks") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            ks = vec3(x, y, z);
-        }
-        else if (token == "Ns") {
-            iss >> ns;
-        }
-    }
-
-    file.close();
-    return true;
-}
\ No newline at end of file
+void setMaterialUniforms(GLuint shaderID, const Material& material) {
+    glUseProgram(shaderID);
+    glUniform3fv(glGetUniformLocation(shaderID, "Ka"), 1, value_ptr(material.ka));
+    glUniform3fv(glGetUniformLocation(shaderID, "Kd"), 1, value_ptr(material.kd));
+    glUniform3fv(glGetUniformLocation(shaderID, "Ks"), 1, value_ptr(material.ks));
+    glUniform1f(glGetUniformLocation(shaderID, "Ns"), material.ns);
+}
@@ -25,8 +25,11 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+// Texturas do .ctex com os mips prontos, sob um orçamento de memória (common/)
+#include "TextureContainer.h"
+#include "TextureResidency.h"
+
+#include <memory>
 
 using namespace glm;
 
@@ -44,6 +47,11 @@ GLuint loadTexture(string filePath, int &width, int &height);
 const GLuint WIDTH = 800, HEIGHT = 600;
 const int NUM_CUBES = 3;
 
+// Orçamento de memória de textura (ver TextureResidency.h): acima dele as
+// texturas perdem os níveis mais finos, começando pelas dos cubos mais
+// distantes ou fora de uso, em vez de esgotar a memória
+const size_t TEXTURE_BUDGET_MB = 64;
+
 // Variáveis de controle dos cubos
 struct Cube {
     vec3 position;
@@ -57,6 +65,9 @@ std::vector<Cube> cubes;
 int currentCube = 0;
 bool useTexture = true; // Inicializa como true para mostrar a textura por padrão
 
+// Todas as texturas de loadTexture, contadas no orçamento
+TextureResidency textureResidency;
+
 // Código fonte do Vertex Shader (em GLSL): ainda hardcoded
 const GLchar *vertexShaderSource = R"(
 #version 400
@@ -154,6 +165,7 @@ int main()
 
 	// Carregando uma textura e armazenando seu id
 	int imgWidth, imgHeight;
+	textureResidency.budgetBytes = TEXTURE_BUDGET_MB << 20;
 	GLuint texID = loadTexture("../assets/tex/pixelWall.png",imgWidth,imgHeight);
 
 	glUseProgram(shaderID);
@@ -186,6 +198,9 @@ int main()
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+	// Pixels por unidade a uma unidade de distância, para o tamanho dos cubos na tela
+	float pixelsPerUnit = HEIGHT / (2.0f * tan(radians(45.0f) * 0.5f));
+
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
@@ -215,17 +230,30 @@ int main()
 			glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
 			glUniform1i(glGetUniformLocation(shaderID, "useTexture"), useTexture);
 
+			// Quanto da textura o cubo mostra: de longe os níveis mais finos sobram
+			if (useTexture)
+				textureResidency.touch(texID, cubes[i].scale * pixelsPerUnit / std::max(-cubes[i].position.z, 0.1f));
+
 			// Desenha o cubo
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
 
 		glBindVertexArray(0); // Desconectando o buffer de geometria
 
+		// Ajusta os níveis residentes das texturas ao orçamento
+		TextureResidencyStats residency = textureResidency.update();
+		if (residency.droppedLevels > 0 || residency.restoredLevels > 0)
+			cout << "Texturas: " << residency.droppedLevels << " nível(is) liberado(s) (" << residency.droppedBytes / 1024
+				 << " KB), " << residency.restoredLevels << " restaurado(s) (" << residency.restoredBytes / 1024
+				 << " KB); " << textureResidency.residentBytes() / 1024 << " KB na GPU" << endl;
+
 		// Troca os buffers da tela
 		glfwSwapBuffers(window);
 	}
 	// Pede pra OpenGL desalocar os buffers
 	glDeleteVertexArrays(1, &VAO);
+	textureResidency.printStats();
+	textureResidency.destroy();
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
 	return 0;
@@ -439,49 +467,19 @@ int setupGeometry()
 GLuint loadTexture(string filePath, int &width, int &height)
 {
     cout << "Tentando carregar textura: " << filePath << endl;
-    
-    GLuint texID;
-    glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_2D, texID);
-
-    // Ajuste dos parâmetros de wrapping e filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Carregamento da imagem
-    int nrChannels;
-    stbi_set_flip_vertically_on_load(true); // Inverte a imagem no eixo y
-
-    unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-    if (data)
-    {
-        cout << "Textura carregada com sucesso!" << endl;
-        cout << "Dimensões: " << width << "x" << height << endl;
-        cout << "Canais: " << nrChannels << endl;
-
-        if (nrChannels == 3) // jpg, bmp
-        {
-            cout << "Formato: RGB" << endl;
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        }
-        else
-        {
-            cout << "Formato: RGBA" << endl;
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        }
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
+    // Todos os níveis vêm do .ctex (gerado na primeira carga), que fica
+    // mapeado para o orçamento reenviar os níveis que liberar
+    auto texture = make_shared<PreparedTexture>();
+    if (!prepareTexture(filePath, *texture))
     {
         cout << "Falha ao carregar textura: " << filePath << endl;
-        cout << "Erro STB: " << stbi_failure_reason() << endl;
+        width = height = 0;
+        return 0;
     }
+    width = (int)texture->width;
+    height = (int)texture->height;
+    cout << "Dimensões: " << width << "x" << height << endl;
 
-    stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return texID;
+    return textureResidency.loadTexture(texture);
 }
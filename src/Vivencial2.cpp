@@ -18,8 +18,21 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+// Carregador de OBJ e malhas indexadas compartilhados (common/)
+#include "ObjLoader.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+#include "Meshlets.h"
+#include "AssetLoader.h"
+#include "AssetWatcher.h"
+#include "Material.h"
+#include "PixelUploadRing.h"
+#include "TextureArrays.h"
+#include "TextureContainer.h"
+#include "VirtualTexture.h"
+
+#include <memory>
+#include <set>
 
 using namespace glm;
 
@@ -36,21 +49,42 @@ struct Light {
 // Variáveis globais para as luzes
 Light keyLight, fillLight, backLight;
 
+// Deslocamento do objeto no eixo z (teclas W/S), para observar a troca de LOD
+float objectDepth = 0.0f;
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 
 // Protótipos das funções
-int setupShader();
-GLuint loadTexture(string filePath, int &width, int &height);
-bool loadMTL(const char* path, vec3& ka, vec3& kd, vec3& ks, float& ns);
-bool loadOBJ(const char* path, vector<vec3>& out_vertices, vector<vec2>& out_uvs, vector<vec3>& out_normals);
-GLuint createVAOFromOBJ(const char* objPath, int& nVertices);
+int setupShader(const GLchar* vertexSource, const GLchar* fragmentSource);
+void setMaterialUniforms(GLuint shaderID, const Material& material);
 void setupLights(const vec3& objectPosition, const vec3& objectScale);
 void printInstructions();
 
 // Dimensões da janela
 const GLuint WIDTH = 800, HEIGHT = 800;
 
+// Envia malhas e texturas por uma thread com contexto GL compartilhado; sem
+// ela, os envios são fatiados no laço com no máximo UPLOAD_BUDGET_MS por quadro
+const bool SHARED_UPLOAD_CONTEXT = true;
+const double UPLOAD_BUDGET_MS = 2.0;
+
+// As texturas vão pelos envios fatiados, com as faixas passando por dois PBOs
+// reciclados por fences (glTexSubImage2D lê do PBO, sem cópia síncrona no
+// driver), mesmo com a thread de envio, que fica só com as malhas
+const bool PBO_TEXTURE_UPLOADS = true;
+
+// Texturas vêm do .ctex ao lado da imagem, com os mips prontos (gerado na
+// primeira carga ou com "AssetBench convert"); comprimidas em BC1/BC3 quando
+// o driver aceita S3TC, senão em RGBA8
+const bool COMPRESS_TEXTURES = true;
+
+// Texturas virtuais (ver VirtualTexture.h) no lugar dos arrays: só as páginas
+// vistas ficam na GPU, em um cache de VT_CACHE_PAGES x VT_CACHE_PAGES páginas,
+// qualquer que seja o tamanho das texturas. Usa o .ctex em RGBA8
+const bool VIRTUAL_TEXTURES = false;
+const int VT_CACHE_PAGES = 16;
+
 // Código fonte do Vertex Shader
 const GLchar *vertexShaderSource = R"(
 #version 400
@@ -63,29 +97,51 @@ uniform mat4 projection;
 uniform mat4 model;
 uniform mat4 view;
 
+// Dequantização dos vértices compactados (ver setMeshUniforms)
+uniform vec3 posScale = vec3(1.0);
+uniform vec3 posOffset = vec3(0.0);
+uniform vec2 uvScale = vec2(1.0);
+uniform vec2 uvOffset = vec2(0.0);
+uniform bool octNormals = false;
+
+// Mesma profundidade da pré-passada (ver depthVertexShaderSource)
+invariant gl_Position;
+
 out vec2 texCoord;
 out vec3 fragNormal;
 out vec3 fragPos;
 out vec4 vColor;
 
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0);
-    fragPos = vec3(model * vec4(position, 1.0));
-    fragNormal = mat3(transpose(inverse(model))) * normal;
-    texCoord = texc;
+    vec3 pos = position * posScale + posOffset;
+    vec3 n = octNormals ? decodeOctahedral(normal.xy / 32767.0) : normal;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+    fragPos = vec3(model * vec4(pos, 1.0));
+    fragNormal = mat3(transpose(inverse(model))) * n;
+    texCoord = texc * uvScale + uvOffset;
     vColor = vec4(color, 1.0);
 })";
 
-// Código fonte do Fragment Shader
+// Código fonte do Fragment Shader (o #version e as funções de
+// virtualTextureGLSL são prefixados em main)
 const GLchar *fragmentShaderSource = R"(
-#version 400
 in vec2 texCoord;
 in vec3 fragNormal;
 in vec3 fragPos;
 in vec4 vColor;
 
-uniform sampler2D texBuff;
+uniform sampler2DArray texBuff;
+uniform int texLayer; // camada do material no array vinculado
+uniform bool virtualTexture; // amostra a textura virtual em vez do array
 uniform vec3 viewPos;
 uniform bool useTexture;
 
@@ -116,7 +172,7 @@ void main()
     vec3 viewDir = normalize(viewPos - fragPos);
     
     vec3 result = vec3(0.0);
-    vec4 texColor = texture(texBuff, texCoord);
+    vec4 texColor = virtualTexture ? sampleVirtual(texCoord) : texture(texBuff, vec3(texCoord, texLayer));
     vec4 baseColor = useTexture ? texColor : vColor;
     
     // Calculate contribution from each light
@@ -145,6 +201,48 @@ void main()
     color = vec4(result * vec3(baseColor), baseColor.a);
 })";
 
+// Pré-passada de profundidade: lê só o fluxo de posição da malha, assim o
+// shader de iluminação (3 luzes) roda uma vez por pixel visível
+const GLchar *depthVertexShaderSource = R"(
+#version 400
+layout (location = 0) in vec3 position;
+
+uniform mat4 projection;
+uniform mat4 model;
+uniform mat4 view;
+
+uniform vec3 posScale = vec3(1.0);
+uniform vec3 posOffset = vec3(0.0);
+
+invariant gl_Position;
+
+void main()
+{
+    vec3 pos = position * posScale + posOffset;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+})";
+
+const GLchar *depthFragmentShaderSource = R"(
+#version 400
+void main()
+{
+})";
+
+// Passada de feedback das texturas virtuais, com o vertex shader principal;
+// prefixado como o fragment shader principal
+const GLchar *feedbackFragmentShaderSource = R"(
+in vec2 texCoord;
+
+uniform int vtTexture;
+uniform float vtLodBias; // a passada tem resolução menor: derivadas maiores
+
+out vec4 feedback;
+
+void main()
+{
+    feedback = virtualFeedback(texCoord, vtTexture, vtLodBias);
+})";
+
 void setupLights(const vec3& objectPosition, const vec3& objectScale) {
     float maxScale = std::max(std::max(objectScale.x, objectScale.y), objectScale.z);
     float distance = maxScale * 3.0f;  // Aumentei a distância para 3x
@@ -186,6 +284,13 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
             case GLFW_KEY_3:  // Back Light
                 backLight.enabled = !backLight.enabled;
                 break;
+            case GLFW_KEY_W:  // Afasta o objeto
+                objectDepth -= 2.0f;
+                break;
+            case GLFW_KEY_S:  // Aproxima o objeto
+                if (objectDepth < 0.0f)
+                    objectDepth += 2.0f;
+                break;
         }
     }
 }
@@ -195,12 +300,16 @@ void printInstructions() {
     cout << "Tecla 1: Liga/Desliga Key Light (luz principal, mais intensa)" << endl;
     cout << "Tecla 2: Liga/Desliga Fill Light (luz de preenchimento, suaviza sombras)" << endl;
     cout << "Tecla 3: Liga/Desliga Back Light (contraluz, adiciona profundidade)" << endl;
+    cout << "Teclas W/S: Afasta/Aproxima o objeto (troca o nível de detalhe)" << endl;
     cout << "ESC: Fecha a aplicação" << endl;
     cout << "===========================" << endl;
 }
 
 int main()
 {
+    // Latências de carregamento contadas desde o início do programa
+    LoadTimer loadTimer;
+
     glfwInit();
 
     GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Vivencial 2 - Iluminação de 3 Pontos", nullptr, nullptr);
@@ -217,10 +326,258 @@ int main()
     // Imprime as instruções de controle
     printInstructions();
 
-    GLuint shaderID = setupShader();
+    string fragmentSource = "#version 400\n" + virtualTextureGLSL() + fragmentShaderSource;
+    GLuint shaderID = setupShader(vertexShaderSource, fragmentSource.c_str());
+    GLuint depthShaderID = setupShader(depthVertexShaderSource, depthFragmentShaderSource);
+
+    // Malha, materiais e texturas são lidos em threads de trabalho; até
+    // chegarem um cubo com textura xadrez e o material padrão ocupam o lugar do modelo
+    AssetLoader loader;
+    GpuMesh mesh = createPlaceholderMesh(vec3(0.5f));
+    int currentLevel = -1;
+
+    // Envios para a GPU: inteiros em uma thread com contexto compartilhado
+    // ou, sem ela, fatiados dentro do laço de renderização
+    UploadThread uploadThread;
+    bool threadedUploads = SHARED_UPLOAD_CONTEXT && uploadThread.start(window);
+    UploadScheduler uploads;
+    uploads.budgetMs = UPLOAD_BUDGET_MS;
+    PixelUploadRing pixelRing;
+    if (PBO_TEXTURE_UPLOADS) {
+        pixelRing.create();
+        uploads.pixelRing = &pixelRing;
+    }
+
+    // Cada asset tem uma função de carga, usada na abertura e nas recargas;
+    // `done` roda na thread do GL logo depois da troca
+    const string modelPath = "../assets/Modelos3D/Suzanne.obj";
+    const string texturePath = "../assets/tex/pixelWall.png"; // materiais sem map_Kd
+    vec3 modelColor(1.0f, 0.0f, 0.0f);
+
+    // Recarga ao salvar: cada arquivo recarrega só o próprio asset (um .mtl
+    // alterado não relê o .obj), com a troca feita entre dois quadros
+    AssetWatcher watcher;
+    auto reportReload = [](const string& path, AssetWatcher::Clock::time_point detected) {
+        return [path, detected] {
+            double ms = chrono::duration<double, milli>(AssetWatcher::Clock::now() - detected).count();
+            cout << "Recarregado: " << path << " em " << ms << " ms" << endl;
+        };
+    };
+
+    // Materiais do .mtl e, para cada material da malha (MeshRange::material),
+    // a posição dele na lista; refeito quando a malha ou o .mtl mudam
+    string materialPath;
+    vector<Material> materials;
+    vector<int> materialSlots;
+    Material defaultMaterial;
+
+    // Texturas lidas do .ctex mapeado em threads de trabalho pelo TextureCache
+    // e empacotadas em GL_TEXTURE_2D_ARRAY (uma camada por textura, um array
+    // por formato e tamanho) pela thread de envio ou pela fila de envios; os
+    // materiais guardam array e camada em vez da textura. Cada empacotamento
+    // pede ao cache todas as texturas conhecidas (só as alteradas são relidas)
+    // e só vale se ainda for o mais recente; até o primeiro, o xadrez
+    TextureBuildOptions textureOptions;
+    textureOptions.compress = COMPRESS_TEXTURES && !VIRTUAL_TEXTURES && textureFormatSupported(TEXTURE_BC1);
+    TextureCache textureCache(loader, textureOptions);
+    GLuint placeholderTexture = createPlaceholderTextureArray();
+    TextureArraySet textureArrays;
+    set<string> texturePaths;
+    unsigned textureGeneration = 0;
+    auto assignLayers = [&] {
+        assignTextureLayer(textureArrays, defaultMaterial, texturePath);
+        for (Material& material : materials)
+            assignTextureLayer(textureArrays, material, texturePath);
+    };
+    auto installArrays = [&](unsigned generation, TextureArraySet& packed, function<void()> done) {
+        if (generation != textureGeneration) {
+            packed.destroy();
+            return;
+        }
+        textureArrays.destroy();
+        textureArrays = std::move(packed);
+        assignLayers();
+        if (done)
+            done();
+    };
+    auto packTextures = [&](function<void()> done) {
+        unsigned generation = ++textureGeneration;
+        auto prepared = make_shared<vector<shared_ptr<PreparedTexture>>>();
+        auto remaining = make_shared<size_t>(texturePaths.size());
+        for (const string& path : texturePaths) {
+            textureCache.request(path, [&, generation, prepared, remaining, done](shared_ptr<PreparedTexture> texture) {
+                if (texture)
+                    prepared->push_back(texture);
+                if (--*remaining > 0 || generation != textureGeneration)
+                    return;
+                if (threadedUploads && !PBO_TEXTURE_UPLOADS) {
+                    auto packed = make_shared<TextureArraySet>();
+                    uploadThread.submit([prepared, packed] { *packed = packTextureArrays(*prepared); },
+                                        [&, generation, packed, done] { installArrays(generation, *packed, done); });
+                }
+                else
+                    packTextureArraysScheduled(uploads, *prepared, [&, generation, done](TextureArraySet& packed) {
+                        installArrays(generation, packed, done);
+                    });
+            });
+        }
+    };
+    // Textura alterada no disco: com o mesmo formato e tamanho só a camada
+    // dela é reenviada; senão tudo é empacotado de novo
+    auto reloadTexture = [&](const string& path, function<void()> done) {
+        textureCache.request(path, [&, done](shared_ptr<PreparedTexture> texture) {
+            if (!texture)
+                return;
+            if (!textureArrays.replace(*texture))
+                packTextures(done);
+            else if (done)
+                done();
+        });
+    };
+
+    // Com texturas virtuais cada textura entra (ou é trocada, na recarga) no
+    // sistema sozinha; as páginas chegam conforme o feedback pede
+    VirtualTextureSystem virtualTextures;
+    virtualTextures.cachePages = VT_CACHE_PAGES;
+    GLuint feedbackShaderID = 0;
+    if (VIRTUAL_TEXTURES) {
+        virtualTextures.create(WIDTH, HEIGHT);
+        string feedbackSource = "#version 400\n" + virtualTextureGLSL() + feedbackFragmentShaderSource;
+        feedbackShaderID = setupShader(vertexShaderSource, feedbackSource.c_str());
+    }
+    auto loadVirtualTexture = [&](const string& path, function<void()> done) {
+        textureCache.request(path, [&, path, done](shared_ptr<PreparedTexture> texture) {
+            if (texture && virtualTextures.addTexture(path, texture) >= 0 && done)
+                done();
+        });
+    };
+
+    // Registra a textura e passa a observar o arquivo; false se já era conhecida
+    auto watchTexture = [&](const string& path) {
+        if (!texturePaths.insert(path).second)
+            return false;
+        watcher.watch(path, [&](const string& changed, AssetWatcher::Clock::time_point detected) {
+            textureCache.invalidate(changed);
+            if (VIRTUAL_TEXTURES)
+                loadVirtualTexture(changed, reportReload(changed, detected));
+            else
+                reloadTexture(changed, reportReload(changed, detected));
+        });
+        if (VIRTUAL_TEXTURES)
+            loadVirtualTexture(path, nullptr);
+        return true;
+    };
+    watchTexture(texturePath);
+    if (!VIRTUAL_TEXTURES)
+        packTextures(nullptr);
+
+    // Na primeira lista, passa a observar o .mtl, que se recarrega sozinho
+    function<void(const string&, vector<Material>&)> applyMaterials;
+    applyMaterials = [&](const string& path, vector<Material>& library) {
+        if (library.empty())
+            return;
+        if (materialPath.empty()) {
+            materialPath = path;
+            watcher.watch(path, [&](const string& changed, AssetWatcher::Clock::time_point detected) {
+                auto done = reportReload(changed, detected);
+                loadMaterialsAsync(loader, changed, [&, done](const string& mtl, vector<Material>& reloaded) {
+                    applyMaterials(mtl, reloaded);
+                    done();
+                });
+            });
+        }
+        materials = std::move(library);
+        materialSlots = resolveMaterials(materials, mesh.materials);
+        assignLayers();
+        bool newTextures = false;
+        for (const Material& material : materials)
+            if (!material.diffuseMap.empty() && watchTexture(material.diffuseMap))
+                newTextures = true;
+        if (newTextures && !VIRTUAL_TEXTURES)
+            packTextures(nullptr);
+    };
+
+    // Vértices únicos + índices, desenhados com glDrawElements. A partir da
+    // segunda execução a malha vem pronta do arquivo .meshcache, já em 16
+    // bytes por vértice; UV de 16 bits para não distorcer a textura.
+    // Na primeira carga o mtllib dispara, ainda durante a leitura do OBJ, a
+    // leitura do .mtl e, logo que ele chega, a das texturas do .ctex
+    auto loadModel = [&](function<void()> done, bool prefetchMaterials) {
+        auto onMeshReady = [&, done](GpuMesh& loaded) {
+            if (loaded.VAO != 0) {
+                deleteMesh(mesh);
+                mesh = loaded;
+                currentLevel = -1;
+                if (!materials.empty())
+                    materialSlots = resolveMaterials(materials, mesh.materials);
+            }
+            if (done)
+                done();
+        };
+        MaterialLibraryHook prefetch;
+        if (prefetchMaterials) {
+            prefetch = [&](const string& mtlPath) {
+                loadMaterialsAsync(
+                    loader, mtlPath, [&](const string& mtl, vector<Material>& library) { applyMaterials(mtl, library); },
+                    &textureCache);
+            };
+        }
+        if (threadedUploads)
+            loadMeshAsync(loader, uploadThread, modelPath.c_str(), modelColor, VERTEX_FORMAT_PRECISE, onMeshReady,
+                          prefetch);
+        else
+            loadMeshAsync(loader, uploads, modelPath.c_str(), modelColor, VERTEX_FORMAT_PRECISE, onMeshReady,
+                          prefetch);
+    };
+    loadModel(nullptr, true);
+
+    watcher.watch(modelPath, [&](const string& path, AssetWatcher::Clock::time_point detected) {
+        loadModel(reportReload(path, detected), false);
+    });
+
+    // As faixas da malha vêm ordenadas por material; a cada troca o material
+    // da faixa define os uniforms, inclusive a camada da textura (a do map_Kd
+    // ou a padrão), e o array só é religado quando muda. Texturas do mesmo
+    // tamanho e formato dividem um array: um vínculo para todas
+    GLuint boundTexture = 0;
+    size_t frameBinds = 0, frameDraws = 0;
+    set<pair<int, int>> frameLayers;
+    size_t shownBinds = 0, shownLayers = 0;
+    // Com texturas virtuais o que se troca é a tabela de indireção e os uniforms dela
+    int boundVirtual = -2;
+    auto materialAt = [&](int32_t material) -> const Material& {
+        int slot = material >= 0 && material < (int)materialSlots.size() ? materialSlots[material] : -1;
+        return slot >= 0 ? materials[slot] : defaultMaterial;
+    };
+    auto virtualTextureOf = [&](const Material& material) {
+        return virtualTextures.find(material.diffuseMap.empty() ? texturePath : material.diffuseMap);
+    };
+    auto bindMaterial = [&](int32_t material) {
+        const Material& current = materialAt(material);
+        setMaterialUniforms(shaderID, current);
+
+        if (VIRTUAL_TEXTURES) {
+            int id = virtualTextureOf(current);
+            if (id != boundVirtual) {
+                virtualTextures.setUniforms(shaderID, id, GL_TEXTURE2);
+                boundVirtual = id;
+                frameBinds++;
+            }
+            frameDraws++;
+            frameLayers.insert(make_pair(id, 0));
+            return;
+        }
 
-    int nVertices;
-    GLuint VAO = createVAOFromOBJ("../assets/Modelos3D/Suzanne.obj", nVertices);
+        GLuint texture = current.diffuseArray >= 0 ? textureArrays.arrays[current.diffuseArray].texture
+                                                   : placeholderTexture;
+        if (texture != boundTexture) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+            boundTexture = texture;
+            frameBinds++;
+        }
+        frameDraws++;
+        frameLayers.insert(make_pair(current.diffuseArray, current.diffuseLayer));
+    };
 
     glUseProgram(shaderID);
 
@@ -229,22 +586,6 @@ int main()
     vec3 objectScale(0.5f, 0.5f, 0.5f);
     setupLights(objectPosition, objectScale);
 
-    // Configuração do material
-    vec3 ka, kd, ks;
-    float ns;
-    if (!loadMTL("../assets/Modelos3D/Suzanne.mtl", ka, kd, ks, ns)) {
-        ka = vec3(0.2f);      // Ambiente
-        kd = vec3(0.8f);      // Difuso - aumentei para 0.8
-        ks = vec3(1.0f);      // Especular
-        ns = 64.0f;           // Shininess - aumentei para 64
-    }
-
-    // Uniforms para material
-    glUniform3fv(glGetUniformLocation(shaderID, "Ka"), 1, value_ptr(ka));
-    glUniform3fv(glGetUniformLocation(shaderID, "Kd"), 1, value_ptr(kd));
-    glUniform3fv(glGetUniformLocation(shaderID, "Ks"), 1, value_ptr(ks));
-    glUniform1f(glGetUniformLocation(shaderID, "Ns"), ns);
-
     // Arrays para as propriedades das luzes
     vec3 lightPositions[3] = {keyLight.position, fillLight.position, backLight.position};
     vec3 lightColors[3] = {keyLight.color, fillLight.color, backLight.color};
@@ -266,228 +607,195 @@ int main()
     glUniformMatrix4fv(glGetUniformLocation(shaderID, "view"), 1, GL_FALSE, value_ptr(view));
     glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
 
-    // Carregamento da textura
-    int texWidth, texHeight;
-    GLuint texID = loadTexture("../assets/tex/pixelWall.png", texWidth, texHeight);
-    
-    // Ativa a textura
+    glUseProgram(depthShaderID);
+    glUniformMatrix4fv(glGetUniformLocation(depthShaderID, "view"), 1, GL_FALSE, value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(depthShaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
+
+    // Cache na unidade 1, tabela de indireção na 2 (ver bindMaterial)
+    if (VIRTUAL_TEXTURES) {
+        glUseProgram(feedbackShaderID);
+        glUniformMatrix4fv(glGetUniformLocation(feedbackShaderID, "view"), 1, GL_FALSE, value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(feedbackShaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
+        glUniform1i(glGetUniformLocation(feedbackShaderID, "vtIndirection"), 2);
+        glUniform1f(glGetUniformLocation(feedbackShaderID, "vtLodBias"), -log2((float)VT_FEEDBACK_DIVISOR));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, virtualTextures.cacheTexture());
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, placeholderTexture);
+    }
+    glUseProgram(shaderID);
+
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texID);
     glUniform1i(glGetUniformLocation(shaderID, "texBuff"), 0);
+    glUniform1i(glGetUniformLocation(shaderID, "vtCache"), 1);
+    glUniform1i(glGetUniformLocation(shaderID, "vtIndirection"), 2);
+    glUniform1i(glGetUniformLocation(shaderID, "virtualTexture"), VIRTUAL_TEXTURES);
     glUniform1i(glGetUniformLocation(shaderID, "useTexture"), true);
 
     glEnable(GL_DEPTH_TEST);
+    // Malhas opacas e fechadas, frente em sentido anti-horário: as faces de costas
+    // não entram em nenhuma das passadas
+    glEnable(GL_CULL_FACE);
+
+    // Pixels por unidade a uma unidade de distância, para projetar o erro dos LODs
+    float pixelsPerUnit = HEIGHT / (2.0f * tan(radians(45.0f) * 0.5f));
+    MeshletDrawList meshletList;
 
     while (!glfwWindowShouldClose(window))
     {
         glfwPollEvents();
 
+        // Envia para a GPU o que as threads de trabalho terminaram
+        watcher.poll();
+        loader.poll();
+        uploadThread.poll();
+        UploadStats uploaded = uploads.update();
+        if (uploaded.chunks > 0) {
+            cout << "Envio: " << uploaded.bytes / 1024 << " KB em " << uploaded.chunks << " pedaços, "
+                 << uploaded.ms << " ms (" << uploaded.pendingBytes / 1024 << " KB na fila)" << endl;
+            if (uploads.idle()) {
+                cout << "Envios concluídos: " << uploads.total.bytes / 1024 << " KB em " << uploads.busyFrames
+                     << " quadros, pior quadro " << uploads.worstFrameMs << " ms (orçamento " << uploads.budgetMs
+                     << " ms)" << endl;
+                if (uploads.total.textureBytes > 0)
+                    cout << "Texturas " << (uploads.pixelRing ? "por PBO" : "diretas") << ": "
+                         << uploads.total.textureMs / (uploads.total.textureBytes / (1024.0 * 1024.0))
+                         << " ms de CPU por MB, " << uploads.total.ringFullFrames << " quadros com os PBOs ocupados"
+                         << endl;
+            }
+        }
+
+        // Páginas pedidas pelos feedbacks que já voltaram da GPU
+        if (VIRTUAL_TEXTURES) {
+            VirtualTextureStats paged = virtualTextures.update();
+            if (paged.uploaded > 0 || paged.evicted > 0)
+                cout << "Páginas virtuais: " << paged.requested << " pedidas, " << paged.uploaded << " enviadas, "
+                     << paged.evicted << " despejadas, " << paged.missing << " faltando; "
+                     << virtualTextures.residentPages() << " residentes em "
+                     << virtualTextures.cacheBytes() / 1024 << " KB de cache" << endl;
+        }
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Atualiza estado das luzes
-        int lightStates[3] = {keyLight.enabled, fillLight.enabled, backLight.enabled};
-        glUniform1iv(glGetUniformLocation(shaderID, "lightEnabled"), 3, lightStates);
-
         // Matriz de modelo com rotação
         mat4 model = mat4(1.0f);
+        model = translate(model, vec3(0.0f, 0.0f, objectDepth));
         model = rotate(model, (float)glfwGetTime(), vec3(0.0f, 1.0f, 0.0f));
         model = scale(model, objectScale);
-        glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, nVertices);
-        glBindVertexArray(0);
 
-        glfwSwapBuffers(window);
-    }
-
-    glDeleteVertexArrays(1, &VAO);
-    glfwTerminate();
-    return 0;
-}
-
-bool loadOBJ(const char* path, vector<vec3>& out_vertices, vector<vec2>& out_uvs, vector<vec3>& out_normals) {
-    vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-    vector<vec3> temp_vertices;
-    vector<vec2> temp_uvs;
-    vector<vec3> temp_normals;
-
-    FILE* file = fopen(path, "r");
-    if (file == NULL) {
-        printf("Erro ao abrir o arquivo OBJ!\n");
-        return false;
-    }
-
-    while (1) {
-        char lineHeader[128];
-        int res = fscanf(file, "%s", lineHeader);
-        if (res == EOF)
-            break;
-
-        if (strcmp(lineHeader, "v") == 0) {
-            vec3 vertex;
-            fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-            temp_vertices.push_back(vertex);
-        }
-        else if (strcmp(lineHeader, "vt") == 0) {
-            vec2 uv;
-            fscanf(file, "%f %f\n", &uv.x, &uv.y);
-            temp_uvs.push_back(uv);
+        // Nível de detalhe com erro projetado abaixo de 1 pixel
+        float distance = length(cameraPos - vec3(0.0f, 0.0f, objectDepth));
+        int level = selectMeshLod(mesh, distance, objectScale.x, pixelsPerUnit);
+        if (level != currentLevel) {
+            currentLevel = level;
+            cout << "LOD " << level << ": " << meshLod(mesh, level).indexCount / 3 << " triângulos" << endl;
         }
-        else if (strcmp(lineHeader, "vn") == 0) {
-            vec3 normal;
-            fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-            temp_normals.push_back(normal);
-        }
-        else if (strcmp(lineHeader, "f") == 0) {
-            unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-            int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n",
-                &vertexIndex[0], &uvIndex[0], &normalIndex[0],
-                &vertexIndex[1], &uvIndex[1], &normalIndex[1],
-                &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-
-            if (matches != 9) {
-                printf("Arquivo OBJ não pode ser lido. Tente exportar com outras opções\n");
-                return false;
-            }
 
-            vertexIndices.push_back(vertexIndex[0]);
-            vertexIndices.push_back(vertexIndex[1]);
-            vertexIndices.push_back(vertexIndex[2]);
-            uvIndices.push_back(uvIndex[0]);
-            uvIndices.push_back(uvIndex[1]);
-            uvIndices.push_back(uvIndex[2]);
-            normalIndices.push_back(normalIndex[0]);
-            normalIndices.push_back(normalIndex[1]);
-            normalIndices.push_back(normalIndex[2]);
+        // No nível 0 descarta os meshlets fora do frustum ou de costas para a
+        // câmera; os níveis simplificados são desenhados inteiros
+        if (level == 0) {
+            vec3 objectCamera = vec3(inverse(model) * vec4(cameraPos, 1.0f));
+            cullMeshlets(mesh, projection * view * model, objectCamera, meshletList);
         }
-    }
 
-    // Processando os índices
-    for (unsigned int i = 0; i < vertexIndices.size(); i++) {
-        unsigned int vertexIndex = vertexIndices[i];
-        unsigned int uvIndex = uvIndices[i];
-        unsigned int normalIndex = normalIndices[i];
+        // Feedback das texturas virtuais: página e nível que cada pixel quer,
+        // em resolução reduzida e com profundidade própria
+        if (VIRTUAL_TEXTURES) {
+            glUseProgram(feedbackShaderID);
+            glUniformMatrix4fv(glGetUniformLocation(feedbackShaderID, "model"), 1, GL_FALSE, value_ptr(model));
+            setMeshUniforms(feedbackShaderID, mesh);
+            int feedbackVirtual = -2;
+            auto bindFeedback = [&](int32_t material) {
+                int id = virtualTextureOf(materialAt(material));
+                if (id != feedbackVirtual) {
+                    virtualTextures.setUniforms(feedbackShaderID, id, GL_TEXTURE2);
+                    feedbackVirtual = id;
+                }
+            };
+            virtualTextures.beginFeedback();
+            if (level == 0)
+                drawMeshlets(mesh, meshletList, false, bindFeedback);
+            else
+                drawMesh(mesh, level, bindFeedback);
+            virtualTextures.endFeedback();
+        }
 
-        vec3 vertex = temp_vertices[vertexIndex - 1];
-        vec2 uv = temp_uvs[uvIndex - 1];
-        vec3 normal = temp_normals[normalIndex - 1];
+        // Pré-passada: só profundidade, lendo só as posições
+        glUseProgram(depthShaderID);
+        glUniformMatrix4fv(glGetUniformLocation(depthShaderID, "model"), 1, GL_FALSE, value_ptr(model));
+        setMeshUniforms(depthShaderID, mesh);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        if (level == 0)
+            drawMeshlets(mesh, meshletList, true);
+        else
+            drawMeshPositions(mesh, level);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        // Passada de iluminação sobre a profundidade já gravada
+        glUseProgram(shaderID);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
 
-        out_vertices.push_back(vertex);
-        out_uvs.push_back(uv);
-        out_normals.push_back(normal);
-    }
+        // Atualiza estado das luzes
+        int lightStates[3] = {keyLight.enabled, fillLight.enabled, backLight.enabled};
+        glUniform1iv(glGetUniformLocation(shaderID, "lightEnabled"), 3, lightStates);
 
-    fclose(file);
-    return true;
-}
+        glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
 
-GLuint createVAOFromOBJ(const char* objPath, int& nVertices) {
-    vector<vec3> vertices;
-    vector<vec2> uvs;
-    vector<vec3> normals;
-    vector<GLfloat> vboData;
+        setMeshUniforms(shaderID, mesh);
+        // Texturas recarregadas podem ter reaproveitado o nome da anterior
+        boundTexture = 0;
+        boundVirtual = -2;
+        frameBinds = frameDraws = 0;
+        frameLayers.clear();
+        if (level == 0)
+            drawMeshlets(mesh, meshletList, false, bindMaterial);
+        else
+            drawMesh(mesh, level, bindMaterial);
+
+        // Sem os arrays seria um vínculo por textura distinta do quadro
+        if (frameBinds != shownBinds || frameLayers.size() != shownLayers) {
+            shownBinds = frameBinds;
+            shownLayers = frameLayers.size();
+            cout << "Texturas por quadro: " << frameBinds << (VIRTUAL_TEXTURES ? " tabela(s)" : " vínculo(s) de array")
+                 << " para " << frameLayers.size()
+                 << " textura(s) em " << frameDraws << " desenho(s)" << endl;
+        }
 
-    if (!loadOBJ(objPath, vertices, uvs, normals)) {
-        return 0;
-    }
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
 
-    vec3 color(1.0f, 0.0f, 0.0f); // Cor padrão vermelha
-
-    // Montando o VBO com todos os atributos
-    for (size_t i = 0; i < vertices.size(); i++) {
-        // Posição
-        vboData.push_back(vertices[i].x);
-        vboData.push_back(vertices[i].y);
-        vboData.push_back(vertices[i].z);
-        
-        // Cor
-        vboData.push_back(color.r);
-        vboData.push_back(color.g);
-        vboData.push_back(color.b);
-        
-        // Normal
-        vboData.push_back(normals[i].x);
-        vboData.push_back(normals[i].y);
-        vboData.push_back(normals[i].z);
-        
-        // UV
-        vboData.push_back(uvs[i].x);
-        vboData.push_back(uvs[i].y);
+        glfwSwapBuffers(window);
+        loadTimer.frameShown(loader.pending() == 0 && uploads.idle() && uploadThread.pending() == 0);
     }
 
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vboData.size() * sizeof(GLfloat), vboData.data(), GL_STATIC_DRAW);
-
-    // Posição (location = 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(0);
-
-    // Cor (location = 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-
-    // Normal (location = 2)
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(2);
-
-    // UV (location = 3)
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(9 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(3);
-
-    glBindVertexArray(0);
-
-    nVertices = vertices.size();
-    return VAO;
+    // As threads de trabalho entregam malhas à thread de envio: param antes dela
+    loader.stop();
+    uploadThread.stop();
+    pixelRing.destroy();
+    deleteMesh(mesh);
+    textureArrays.destroy();
+    virtualTextures.destroy();
+    glDeleteTextures(1, &placeholderTexture);
+    glDeleteProgram(feedbackShaderID);
+    glDeleteProgram(depthShaderID);
+    glfwTerminate();
+    return 0;
 }
 
-bool loadMTL(const char* path, vec3& ka, vec3& kd, vec3& ks, float& ns) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        std::cout << "Erro ao abrir arquivo MTL: " << path << std::endl;
-        return false;
-    }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string token;
-        iss >> token;
-
-        if (token == "Ka") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            ka = vec3(x, y, z);
-        }
-        else if (token == "Kd") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            kd = vec3(x, y, z);
-        }
-        else if (token == "Ks") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            ks = vec3(x, y, z);
-        }
-        else if (token == "Ns") {
-            iss >> ns;
-        }
-    }
-
-    file.close();
-    return true;
+void setMaterialUniforms(GLuint shaderID, const Material& material) {
+    glUseProgram(shaderID);
+    glUniform3fv(glGetUniformLocation(shaderID, "Ka"), 1, value_ptr(material.ka));
+    glUniform3fv(glGetUniformLocation(shaderID, "Kd"), 1, value_ptr(material.kd));
+    glUniform3fv(glGetUniformLocation(shaderID, "Ks"), 1, value_ptr(material.ks));
+    glUniform1f(glGetUniformLocation(shaderID, "Ns"), material.ns);
+    glUniform1i(glGetUniformLocation(shaderID, "texLayer"), material.diffuseArray >= 0 ? material.diffuseLayer : 0);
 }
 
-int setupShader() {
+int setupShader(const GLchar* vertexSource, const GLchar* fragmentSource) {
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
     glCompileShader(vertexShader);
 
     GLint success;
@@ -499,7 +807,7 @@ int setupShader() {
     }
 
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
     glCompileShader(fragmentShader);
 
     glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
@@ -524,51 +832,3 @@ int setupShader() {
 
     return shaderProgram;
 }
-
-GLuint loadTexture(string filePath, int &width, int &height)
-{
-    cout << "Tentando carregar textura: " << filePath << endl;
-    
-    GLuint texID;
-    glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_2D, texID);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    int nrChannels;
-    stbi_set_flip_vertically_on_load(true);
-
-    unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-    if (data)
-    {
-        cout << "Textura carregada com sucesso!" << endl;
-        cout << "Dimensões: " << width << "x" << height << endl;
-        cout << "Canais: " << nrChannels << endl;
-
-        if (nrChannels == 3) // jpg, bmp
-        {
-            cout << "Formato: RGB" << endl;
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        }
-        else // png com alpha
-        {
-            cout << "Formato: RGBA" << endl;
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        }
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        cout << "Falha ao carregar textura: " << filePath << endl;
-        cout << "Erro STB: " << stbi_failure_reason() << endl;
-    }
-
-    stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return texID;
-}
\ No newline at end of file